@@ -0,0 +1,86 @@
+#include "AdmissionControl.h"
+#include "ConfigMgr.h"
+#include "LogicSystem.h"
+#include "NetworkMetrics.h"
+#include "Utils.h"
+#include <algorithm>
+
+AdmissionControl::AdmissionControl() {
+    SectionInfo section = ConfigMgr::Inst()["Admission"];
+
+    auto readValue = [&section](const std::string& key, auto defaultValue) {
+        std::string value = section[key];
+        return value.empty() ? defaultValue : static_cast<decltype(defaultValue)>(std::stod(value));
+    };
+
+    maxConnections = readValue("MaxConnections", maxConnections);
+    acceptRate = readValue("AcceptRate", acceptRate);
+    acceptBurst = readValue("AcceptBurst", std::max(acceptRate, 1.0));
+    // 默认在读端流控水位的两倍处暂停接受，此时已有连接的读取也已暂停
+    pauseBacklog = readValue("PauseBacklog", SessionConfig::get().recvQueueHigh * 2);
+    resumeBacklog = readValue("ResumeBacklog", pauseBacklog / 2);
+    busyFrame = section["BusyFrame"] != "false";
+
+    tokens = acceptBurst;
+    lastRefill = std::chrono::steady_clock::now();
+}
+
+AdmissionResult AdmissionControl::tryAdmit(std::atomic<size_t>& connections) {
+    if (maxConnections > 0 && connections.fetch_add(1) >= maxConnections) {
+        connections.fetch_sub(1);
+        return AdmissionResult::REJECTED_LIMIT;
+    }
+    if (maxConnections == 0) {
+        connections.fetch_add(1);
+    }
+
+    if (!tryAcquireToken()) {
+        connections.fetch_sub(1);
+        return AdmissionResult::REJECTED_RATE;
+    }
+
+    return AdmissionResult::ACCEPTED;
+}
+
+bool AdmissionControl::tryAcquireToken() {
+    if (acceptRate <= 0) {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(mutexs);
+
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - lastRefill).count();
+    lastRefill = now;
+
+    tokens = std::min(acceptBurst, tokens + elapsed * acceptRate);
+
+    if (tokens < 1.0) {
+        return false;
+    }
+
+    tokens -= 1.0;
+    return true;
+}
+
+bool AdmissionControl::shouldPauseAccept() {
+    if (pauseBacklog == 0) {
+        return false;
+    }
+
+    size_t backlog = LogicSystem::getInstance()->getPendingMessages();
+
+    if (!paused.load() && backlog > pauseBacklog) {
+        if (!paused.exchange(true)) {
+            LOG_WARNING("AdmissionControl: LogicSystem backlog %zu above %zu, pause accepting", backlog, pauseBacklog);
+            NetworkMetrics::getInstance()->recordAcceptPause();
+        }
+    }
+    else if (paused.load() && backlog <= resumeBacklog) {
+        if (paused.exchange(false)) {
+            LOG_INFO("AdmissionControl: LogicSystem backlog %zu below %zu, resume accepting", backlog, resumeBacklog);
+        }
+    }
+
+    return paused.load();
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// 新连接的准入结果
+enum class AdmissionResult {
+    ACCEPTED,
+    REJECTED_LIMIT,   // 超过最大连接数
+    REJECTED_RATE     // 超过接受速率
+};
+
+// 连接准入控制：最大连接数、令牌桶限速，以及 LogicSystem 积压时暂停接受
+// 配置来自 config.ini [Admission]，多个监听协程可并发调用
+class AdmissionControl {
+public:
+    AdmissionControl();
+
+    // 为新连接预留一个连接名额，只有返回 ACCEPTED 时 connections 才会加一
+    AdmissionResult tryAdmit(std::atomic<size_t>& connections);
+
+    // LogicSystem 积压超过暂停水位后返回 true，直到回落到恢复水位以下
+    bool shouldPauseAccept();
+
+    bool sendBusyFrame() const { return busyFrame; }
+
+private:
+    bool tryAcquireToken();
+
+    size_t maxConnections = 0;
+
+    // 每秒令牌数与桶容量，0 表示不限速
+    double acceptRate = 0;
+
+    double acceptBurst = 0;
+
+    size_t pauseBacklog = 0;
+
+    size_t resumeBacklog = 0;
+
+    bool busyFrame = true;
+
+    std::atomic<bool> paused{ false };
+
+    std::mutex mutexs;
+
+    double tokens = 0;
+
+    std::chrono::steady_clock::time_point lastRefill;
+};
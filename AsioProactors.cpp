@@ -2,74 +2,193 @@
 #include "AdvancedSystemMonitor.h"
 #include <iostream>
 #include "Utils.h"
+#include "NetworkMetrics.h"
+#include "ConfigMgr.h"
+#include "CpuTopology.h"
+#include "ThreadBudget.h"
+#include <random>
+#include <stdexcept>
 
-AsioProactors::AsioProactors(size_t minSize, size_t maxSize) :minSize(minSize), maxSize(maxSize), nowSize(minSize)
-, ioContexts(maxSize), works(maxSize), threads(maxSize), ioPressures(maxSize), isStop(false) {
+// ǰʵʱ׽ֺ
+static IoBackend compiledBackend() {
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+	return IoBackend::IO_URING;
+#else
+	return IoBackend::EPOLL;
+#endif
+}
+
+const char* AsioProactors::backendName(IoBackend backend) {
+	return backend == IoBackend::IO_URING ? "io_uring" : "epoll";
+}
 
-	for (int i = 0; i < nowSize; i++) {
-		// ʹµ work guard API
-		auto work = std::make_unique<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>(
-			boost::asio::make_work_guard(ioContexts[i])
-		);
+AsioProactors::AsioProactors(size_t minSize, size_t maxSize) :works(maxSize), threads(maxSize), loads(maxSize), loopStats(maxSize), minSize(ThreadBudget::getInstance()->registerPool("AsioProactors", minSize, maxSize)), maxSize(maxSize), nowSize(this->minSize)
+, isStop(false), autoscaler("AsioProactors", this->minSize, maxSize) {
+
+	// ߳Ԥ׼߳ռ CPU 
+	CpuTopology::getInstance()->reserve("AsioProactors", this->minSize);
+
+	// config.ini [AsioProactors] Backend = epoll | io_uringʱʹñĺ
+	// ֻڱѡʽָĺ벻һʱܾһֺ˾Ĭ
+	std::string requested = ConfigMgr::Inst()["AsioProactors"]["Backend"];
+	backend = compiledBackend();
+	if (!requested.empty() && requested != backendName(backend)) {
+		LOG_ERROR("AsioProactors: Backend %s requested but this build uses %s; io_uring requires building with BOOST_ASIO_HAS_IO_URING and BOOST_ASIO_DISABLE_EPOLL", requested.c_str(), backendName(backend));
+		throw std::runtime_error("AsioProactors: configured I/O backend " + requested + " is not compiled in");
+	}
+	LOG_INFO("AsioProactors: I/O Backend: %s", backendName(backend));
+
+	// config.ini [AsioProactors] ScaleDownMode = migrate | drain
+	SectionInfo section = ConfigMgr::Inst()["AsioProactors"];
+	if (section["ScaleDownMode"] == "drain") {
+		scaleDownMode = ScaleDownMode::DRAIN;
+	}
+	if (!section["ScaleDownTimeoutMs"].empty()) {
+		scaleDownTimeout = std::chrono::milliseconds(std::stoll(section["ScaleDownTimeoutMs"]));
+	}
+
+	// config.ini [AsioProactors] ConcurrencyHint = safe | unsafe_io
+	if (section["ConcurrencyHint"] == "unsafe_io") {
+		concurrencyMode = ConcurrencyMode::UNSAFE_IO;
+	}
+	LOG_INFO("AsioProactors: Concurrency Hint: %s", concurrencyMode == ConcurrencyMode::UNSAFE_IO ? "unsafe_io" : "safe");
 
-		works[i] = std::move(work);
-		threads[i] = std::thread([this, i]() {
-			ioContexts[i].run();
-			});
+	// config.ini [AsioProactors] SpinMicrosǰ poll() ʱ
+	spin = EventLoop::spinBudget("AsioProactors");
+	if (spin.count() > 0) {
+		LOG_INFO("AsioProactors: Spin Before Block: %lldus", static_cast<long long>(spin.count()));
+	}
+
+	for (size_t i = 0; i < maxSize; i++) {
+		ioContexts.push_back(std::make_unique<boost::asio::io_context>(concurrencyHint()));
+		handoffs.push_back(std::make_unique<ContextHandoff>(*ioContexts.back()));
+	}
+
+	for (size_t i = 0; i < nowSize; i++) {
+		startContext(i);
 	}
 	systemMonitorThread = std::thread([this]() {
 		AdvancedSystemMonitor::getInstance()->startMonitoring();
-		while (!isStop) {
-			double pressures = AdvancedSystemMonitor::getInstance()->getSystemLoadAverage();
-			LOG_INFO("AsioProactors: Monitoring system Threads: %d", nowSize.load());
-			LOG_INFO("AsioProactors: System Load Average: %0.2f", pressures);
-			if (pressures > 0.6) {
-				std::lock_guard<std::mutex> lock(mutexs);
-				if (this->nowSize == this->maxSize) {
-					std::this_thread::sleep_for(updateInterval);
-					continue;
-				}
-				size_t newIndex = this->nowSize.fetch_add(1);
-
-				// ʹµ work guard API
-				auto work = std::make_unique<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>(
-					boost::asio::make_work_guard(ioContexts[newIndex])
-				);
-
-				works[newIndex] = std::move(work);
-				threads[newIndex] = std::move(std::thread([this, newIndex]() {
-					ioContexts[newIndex].run();
-					}));
+		auto lastTick = std::chrono::steady_clock::now();
+		auto lastLog = lastTick - updateInterval;
+		LoopTotals lastTotals = EventLoop::totals(loopStats.data(), loopStats.size());
+		LoopTotals loggedTotals = lastTotals;
+		while (!waitForStop(autoscaler.getPolicy().interval)) {
+			auto now = std::chrono::steady_clock::now();
+			double seconds = std::chrono::duration<double>(now - lastTick).count();
+			LoopTotals totals = EventLoop::totals(loopStats.data(), loopStats.size());
+			LoopSnapshot snapshot = EventLoop::snapshot(loopStats.data(), nowSize.load());
+
+			// ʱȡ poll()/poll_one() ʱĴѺִеĴֻ뵽
+			ScalingSignals signals;
+			signals.threads = nowSize.load();
+			signals.arrivalRate = seconds > 0 ? (totals.handlers - lastTotals.handlers) / seconds : 0;
+			signals.serviceMicros = totals.timedHandlers > lastTotals.timedHandlers
+				? (totals.busyNanos - lastTotals.busyNanos) / 1000.0 / (totals.timedHandlers - lastTotals.timedHandlers) : 0;
+			signals.lagP99 = snapshot.lagP99;
+			signals.budgetSurplus = ThreadBudget::getInstance()->surplus("AsioProactors");
+			lastTotals = totals;
+			lastTick = now;
+
+			// autoscaler ֻڼ߳Ϸʣ̵߳ʧܽת
+			size_t failed = failedTarget.exchange(0);
+			if (failed != 0) {
+				autoscaler.onResizeFailed(failed);
+			}
+			if (!retiring.load()) {
+				resize(autoscaler.evaluate(signals));
 			}
-			else if (pressures < 0.3) {
-				std::lock_guard<std::mutex> lock(mutexs);
-				if (this->nowSize == this->minSize) {
-					std::this_thread::sleep_for(updateInterval);
-					continue;
-				}
-				size_t newSize = this->nowSize.fetch_sub(1) - 1;
-				size_t indexToRemove = newSize;
-
-				// ֹͣ io_context  work guard
-				ioContexts[indexToRemove].stop();
-				works[indexToRemove].reset();
-				this->threads[indexToRemove].join();
+
+			if (now - lastLog >= updateInterval) {
+				LOG_INFO("AsioProactors: Monitoring system Threads: %d", nowSize.load());
+				LOG_INFO("AsioProactors: System Load Average: %0.2f", AdvancedSystemMonitor::getInstance()->getSystemLoadAverage());
+				NetworkMetrics::getInstance()->logSnapshot();
+				ThreadBudget::getInstance()->logSnapshot();
+				EventLoop::logStats("AsioProactors", spin, totals, loggedTotals);
+				EventLoop::logLatency("AsioProactors", snapshot);
+				loggedTotals = totals;
+				lastLog = now;
 			}
-			std::this_thread::sleep_for(updateInterval);
 		}
 		});
 }
 
+void AsioProactors::startContext(size_t index) {
+	// ʹµ work guard API
+	auto work = std::make_unique<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>(
+		boost::asio::make_work_guard(*ioContexts[index])
+	);
+
+	works[index] = std::move(work);
+	// ʱù stop()Ҫ restart() ٴ
+	ioContexts[index]->restart();
+	// ǰķֲ
+	loopStats[index].lagHistogram.reset();
+	loopStats[index].handlerRateHistogram.reset();
+	startProbe(index);
+	threads[index] = std::thread([this, index]() {
+		CpuTopology::getInstance()->pinCurrentThread("AsioProactors", index);
+		EventLoop::run(*ioContexts[index], spin, loopStats[index]);
+		});
+}
+
+void AsioProactors::resize(size_t target) {
+	std::lock_guard<std::mutex> lock(mutexs);
+	// ݵ߳ autoscaler ߳Ԥ
+	while (nowSize.load() < target) {
+		size_t newIndex = this->nowSize.load();
+		startContext(newIndex);
+		this->nowSize.fetch_add(1);
+	}
+	if (nowSize.load() > target) {
+		// ȴӷ÷ΧƳ»Ự io_contextȴỰ뿪߳Ͻ
+		startRetire(this->nowSize.fetch_sub(1) - 1, target);
+	}
+}
+
+void AsioProactors::startRetire(size_t index, size_t target) {
+	// һѽretiring Ϊ false ʱŻ resize߳
+	if (retireThread.joinable()) {
+		retireThread.join();
+	}
+	retiring.store(true);
+	retireThread = std::thread([this, index, target]() {
+		bool retired = retireContext(index);
+		std::lock_guard<std::mutex> lock(mutexs);
+		if (retired) {
+			ThreadBudget::getInstance()->release("AsioProactors", 1);
+		}
+		else {
+			this->nowSize.fetch_add(1);
+			failedTarget.store(target);
+		}
+		retiring.store(false);
+		});
+}
+
 AsioProactors::~AsioProactors() {
 	stop();
 }
 
+bool AsioProactors::waitForStop(std::chrono::milliseconds timeout) {
+	std::unique_lock<std::mutex> lock(stopMutex);
+	return stopCondition.wait_for(lock, timeout, [this]() { return isStop.load(); });
+}
+
 void AsioProactors::stop() {
-	isStop = true;
+	{
+		std::lock_guard<std::mutex> lock(stopMutex);
+		isStop = true;
+	}
+	stopCondition.notify_all();
 
 	if (systemMonitorThread.joinable()) {
 		systemMonitorThread.join();
 	}
+	// retireContext ȴʱֹͣ־漴
+	if (retireThread.joinable()) {
+		retireThread.join();
+	}
 	// ֹͣϵͳ
 	AdvancedSystemMonitor::getInstance()->stopMonitoring();
 
@@ -82,7 +201,7 @@ void AsioProactors::stop() {
 
 	// ȷֹͣ io_context
 	for (auto& context : ioContexts) {
-		context.stop();
+		context->stop();
 	}
 
 	for (auto& t : threads) {
@@ -93,11 +212,149 @@ void AsioProactors::stop() {
 }
 
 boost::asio::io_context& AsioProactors::getIoComplatePorts() {
-	int balancing = loadBalancing++;
-	boost::asio::io_context& context = ioContexts[balancing % nowSize];
-	ioPressures[balancing % nowSize]++;
-	if (loadBalancing >= nowSize) {
-		loadBalancing = 0;
-	}
-	return context;
-}
\ No newline at end of file
+	size_t size = nowSize.load();
+	if (size <= 1) {
+		return *ioContexts[0];
+	}
+	thread_local std::minstd_rand random(std::random_device{}());
+	size_t first = random() % size;
+	size_t second = (first + 1 + random() % (size - 1)) % size;
+	return *ioContexts[loadScore(first) <= loadScore(second) ? first : second];
+}
+
+ContextLoad* AsioProactors::getLoad(boost::asio::io_context& context) {
+	for (size_t i = 0; i < ioContexts.size(); i++) {
+		if (ioContexts[i].get() == &context) {
+			return &loads[i];
+		}
+	}
+	return nullptr;
+}
+
+double AsioProactors::loadScore(size_t index) const {
+	const ContextLoad& load = loads[index];
+	// ԻỰΪ׼ÿ 64KB/s »ÿ 100us ¼ѭӳΪһỰ
+	return static_cast<double>(load.sessions.load(std::memory_order_relaxed))
+		+ static_cast<double>(load.bytesPerSecond.load(std::memory_order_relaxed)) / (64 * 1024)
+		+ static_cast<double>(loopStats[index].lagMicros.load(std::memory_order_relaxed)) / 100;
+}
+
+int AsioProactors::concurrencyHint() const {
+	// ÿ io_context ֻһ߳
+	return concurrencyMode == ConcurrencyMode::UNSAFE_IO ? BOOST_ASIO_CONCURRENCY_HINT_UNSAFE_IO : 1;
+}
+
+void AsioProactors::handoff(boost::asio::io_context& context, std::function<void()> task) {
+	for (size_t i = 0; i < ioContexts.size(); i++) {
+		if (ioContexts[i].get() == &context) {
+			handoffs[i]->push(std::move(task));
+			return;
+		}
+	}
+	boost::asio::post(context, std::move(task));
+}
+
+bool AsioProactors::isActive(boost::asio::io_context& context) {
+	ContextLoad* load = getLoad(context);
+	return load == nullptr || static_cast<size_t>(load - loads.data()) < nowSize.load();
+}
+
+void AsioProactors::setSessionMigrator(std::function<void(boost::asio::io_context& victim)> migrator) {
+	std::lock_guard<std::mutex> lock(migratorMutex);
+	sessionMigrator = std::move(migrator);
+}
+
+bool AsioProactors::retireContext(size_t index) {
+	ContextLoad& load = loads[index];
+	auto deadline = std::chrono::steady_clock::now() + scaleDownTimeout;
+	auto lastMigration = std::chrono::steady_clock::time_point();
+	size_t idleChecks = 0;
+
+	// ι۲쵽ûлỰΪſգܿɷáδĻỰ
+	while (idleChecks < 2) {
+		auto now = std::chrono::steady_clock::now();
+		if (load.sessions.load() > 0) {
+			idleChecks = 0;
+			if (now >= deadline) {
+				LOG_WARNING("AsioProactors: scale down of context %zu timed out with %zu sessions, keep it running", index, load.sessions.load());
+				return false;
+			}
+			// δǨƵĻỰдδڿУһ
+			if (scaleDownMode == ScaleDownMode::MIGRATE && now - lastMigration >= std::chrono::milliseconds(100)) {
+				std::lock_guard<std::mutex> lock(migratorMutex);
+				if (sessionMigrator) sessionMigrator(*ioContexts[index]);
+				lastMigration = now;
+			}
+		}
+		else {
+			idleChecks++;
+		}
+		if (waitForStop(std::chrono::milliseconds(50))) {
+			return false;
+		}
+	}
+
+	// ͷ work guard io_context ִͶݵĻصûʣ๤˳
+	load.probeStop.store(true);
+	works[index].reset();
+
+	auto stopDeadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	while (!ioContexts[index]->stopped() && std::chrono::steady_clock::now() < stopDeadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	if (!ioContexts[index]->stopped()) {
+		ioContexts[index]->stop();
+	}
+	threads[index].join();
+
+	LOG_INFO("AsioProactors: context %zu retired", index);
+	return true;
+}
+
+void AsioProactors::startProbe(size_t index) {
+	ContextLoad& load = loads[index];
+	load.probeStop.store(false);
+	if (load.probeRunning.load()) {
+		// ֮ǰ̽ЭԹڸ context ϣǿֹͣ
+		load.resumed.store(true);
+		return;
+	}
+	load.probeRunning.store(true);
+
+	boost::asio::co_spawn(*ioContexts[index], [this, index]() -> boost::asio::awaitable<void> {
+		ContextLoad& load = loads[index];
+		LoopStats& stats = loopStats[index];
+		boost::asio::steady_timer timer(*ioContexts[index]);
+		const std::chrono::milliseconds interval(100);
+		uint64_t lastBytes = load.bytes.load(std::memory_order_relaxed);
+		size_t ticks = 0;
+		auto lastSample = std::chrono::steady_clock::now();
+		stats.probedHandlers = stats.handlers.load(std::memory_order_relaxed);
+
+		while (!load.probeStop.load()) {
+			timer.expires_after(interval);
+			co_await timer.async_wait(boost::asio::use_awaitable);
+
+			co_await EventLoop::probeLag(*ioContexts[index], stats);
+
+			auto now = std::chrono::steady_clock::now();
+
+			if (load.resumed.exchange(false)) {
+				// ֹͣڼֽ봦
+				lastBytes = load.bytes.load(std::memory_order_relaxed);
+				stats.probedHandlers = stats.handlers.load(std::memory_order_relaxed);
+				lastSample = now;
+				ticks = 0;
+			}
+			else if (++ticks % 10 == 0) {
+				uint64_t bytes = load.bytes.load(std::memory_order_relaxed);
+				load.bytesPerSecond.store(bytes - lastBytes, std::memory_order_relaxed);
+				lastBytes = bytes;
+
+				EventLoop::sampleHandlerRate(stats, now - lastSample);
+				lastSample = now;
+			}
+		}
+		load.probeRunning.store(false);
+		}, boost::asio::detached);
+}
@@ -3,6 +3,44 @@
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <condition_variable>
+#include <functional>
+#include "ContextHandoff.h"
+#include "EventLoop.h"
+#include "Autoscaler.h"
+
+// I/O ˣBoost.Asio ڱѡˣio_uring Ҫж
+// BOOST_ASIO_HAS_IO_URING  BOOST_ASIO_DISABLE_EPOLL  liburing
+enum class IoBackend {
+	EPOLL,
+	IO_URING
+};
+
+// io_context ĲʾSAFE Ϊ߳еĬϼʵ֣UNSAFE_IO ر reactor  I/O ļ
+// ʱ socket Ĵ򿪡עᡢرִֻ߳У̵߳Ĳͨ handoff() ƽ
+enum class ConcurrencyMode {
+	SAFE,
+	UNSAFE_IO
+};
+
+// ݷʽȴỰȻ뿪ѻỰǨƵ io_context
+enum class ScaleDownMode {
+	DRAIN,
+	MIGRATE
+};
+
+//  io_context ʵʱأỰ context ϵ̽Э̸
+struct alignas(64) ContextLoad {
+	std::atomic<size_t> sessions{ 0 };
+	// ۼƶдֽ
+	std::atomic<uint64_t> bytes{ 0 };
+	std::atomic<uint64_t> bytesPerSecond{ 0 };
+	// context ֹͣ̽Э趪һβ
+	std::atomic<bool> resumed{ false };
+	// ʱ֪ͨ̽Э˳ʹ io_context ûʣ๤
+	std::atomic<bool> probeStop{ false };
+	std::atomic<bool> probeRunning{ false };
+};
 
 class AsioProactors {
 
@@ -20,25 +58,93 @@ public:
 
 	AsioProactors& operator=(const AsioProactors& asioProactors) = delete;
 
+	// ѡȡ io_contextظؽϵߣpower of two choices
 	boost::asio::io_context& getIoComplatePorts();
 
+	//  context Ӧĸͳƣڱ̳߳ʱ nullptr
+	ContextLoad* getLoad(boost::asio::io_context& context);
+
+	// context ڽ»Ựʱ trueڱ̳߳ص context ΪԾ
+	bool isActive(boost::asio::io_context& context);
+
+	// ʱã victim ϵĻỰǨߣɳлỰ CServer ע
+	void setSessionMigrator(std::function<void(boost::asio::io_context& victim)> migrator);
+
+	IoBackend getBackend() const { return backend; }
+
+	boost::asio::io_context& getIoContext(size_t index) { return *ioContexts[index]; }
+
+	ConcurrencyMode getConcurrencyMode() const { return concurrencyMode; }
+
+	//  io_context ʹõĲʾLogicSystem  io_context Ҳʹøֵ
+	int concurrencyHint() const;
+
+	// ƽ context ִ߳У̳֮߳ context ֱ post
+	void handoff(boost::asio::io_context& context, std::function<void()> task);
+
+	// פ I/O ߳ݲڸֵ
+	size_t getBaseSize() const { return minSize; }
+
+	static const char* backendName(IoBackend backend);
+
 private:
 
+	// ȴ timeout  stop()ֹͣʱ true
+	bool waitForStop(std::chrono::milliseconds timeout);
+
+	// ݣindex Ѳٽ»ỰȴϵĻỰ뿪Ǩߣֹ̣ͣ߳ʱ false
+	bool retireContext(size_t index);
+
+	// ִ߳ retireContext黹߳Ԥ index Żط÷Χڵȴڼ mutexs
+	void startRetire(size_t index, size_t target);
+
+	//  io_context ̽Э̣ÿ 100ms Ͷ̽⴦ӳ٣ÿ봦
+	void startProbe(size_t index);
+
+	double loadScore(size_t index) const;
+
+	// Ϊ index  work guard ߳̽Э
+	void startContext(size_t index);
+
+	// ݵ target ̣ۣ߳ʧʱֵǰС
+	void resize(size_t target);
+
 	AsioProactors(size_t minSize = std::thread::hardware_concurrency() * 2, size_t maxSize = std::thread::hardware_concurrency() * 4);
 
-	std::vector<boost::asio::io_context> ioContexts;
+	// io_context ƶʾ
+	std::vector<std::unique_ptr<boost::asio::io_context>> ioContexts;
+
+	std::vector<std::unique_ptr<ContextHandoff>> handoffs;
 
 	// ʹµ work guard ѷ io_context::work
 	std::vector<std::unique_ptr<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>> works;
 
 	std::vector<std::thread> threads;
-	std::vector<std::atomic<size_t>> ioPressures;
+	std::vector<ContextLoad> loads;
+	std::vector<LoopStats> loopStats;
 	std::mutex mutexs;
 	size_t minSize;
 	size_t maxSize;
 	std::atomic<size_t> nowSize;
-	std::atomic<size_t> loadBalancing = 0;
 	std::thread systemMonitorThread;
+	// ָ־ݰ autoscaler 
 	std::chrono::milliseconds updateInterval{ 30000 };
 	std::atomic<bool> isStop;
+	// ̰߳ȴstop() ʱ
+	std::mutex stopMutex;
+	std::condition_variable stopCondition;
+	IoBackend backend = IoBackend::EPOLL;
+	ScaleDownMode scaleDownMode = ScaleDownMode::MIGRATE;
+	ConcurrencyMode concurrencyMode = ConcurrencyMode::SAFE;
+	// ǰʱ䣬0 Ϊֱ
+	std::chrono::microseconds spin{ 0 };
+	std::chrono::milliseconds scaleDownTimeout{ 30000 };
+	// һֻһ io_contextretiring ڼ߳ճݾ
+	std::thread retireThread;
+	std::atomic<bool> retiring{ false };
+	// δɵĿ꣬ɼ߳ת autoscaler0 ʾû
+	std::atomic<size_t> failedTarget{ 0 };
+	std::mutex migratorMutex;
+	std::function<void(boost::asio::io_context&)> sessionMigrator;
+	Autoscaler autoscaler;
 };
\ No newline at end of file
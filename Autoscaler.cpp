@@ -0,0 +1,136 @@
+#include "Autoscaler.h"
+#include "ConfigMgr.h"
+#include "Utils.h"
+#include "ThreadBudget.h"
+#include <algorithm>
+#include <cmath>
+
+ScalingPolicy ScalingPolicy::load(const std::string& pool) {
+    ScalingPolicy policy;
+    SectionInfo section = ConfigMgr::Inst()["Autoscale." + pool];
+
+    auto readValue = [&section](const std::string& key, long long defaultValue) {
+        std::string value = section[key];
+        return value.empty() ? defaultValue : std::stoll(value);
+    };
+
+    policy.interval = std::chrono::milliseconds(readValue("IntervalMs", policy.interval.count()));
+    policy.targetLatencyMicros = static_cast<uint64_t>(readValue("TargetLatencyMicros", policy.targetLatencyMicros));
+    policy.idleLatencyMicros = static_cast<uint64_t>(readValue("IdleLatencyMicros", policy.idleLatencyMicros));
+    policy.growSamples = static_cast<int>(readValue("GrowSamples", policy.growSamples));
+    policy.shrinkSamples = static_cast<int>(readValue("ShrinkSamples", policy.shrinkSamples));
+    policy.growCooldown = std::chrono::milliseconds(readValue("GrowCooldownMs", policy.growCooldown.count()));
+    policy.shrinkCooldown = std::chrono::milliseconds(readValue("ShrinkCooldownMs", policy.shrinkCooldown.count()));
+    policy.maxGrowStep = static_cast<size_t>(readValue("MaxGrowStep", policy.maxGrowStep));
+
+    if (!section["TargetUtilization"].empty()) {
+        policy.targetUtilization = std::stod(section["TargetUtilization"]);
+    }
+
+    return policy;
+}
+
+Autoscaler::Autoscaler(std::string pool, size_t minSize, size_t maxSize)
+    : pool(std::move(pool)), minSize(minSize), maxSize(maxSize), lastChange(std::chrono::steady_clock::now()) {
+    policy = ScalingPolicy::load(this->pool);
+
+    LOG_INFO("%s: Autoscale %zu-%zu threads, target latency %lluus, idle latency %lluus, utilization %0.2f, cooldown %lld/%lldms",
+        this->pool.c_str(), minSize, maxSize,
+        static_cast<unsigned long long>(policy.targetLatencyMicros),
+        static_cast<unsigned long long>(policy.idleLatencyMicros),
+        policy.targetUtilization,
+        static_cast<long long>(policy.growCooldown.count()),
+        static_cast<long long>(policy.shrinkCooldown.count()));
+}
+
+size_t Autoscaler::requiredThreads(const ScalingSignals& signals) const {
+    if (signals.serviceMicros <= 0 || policy.targetUtilization <= 0) {
+        return 0;
+    }
+    double busy = signals.arrivalRate * signals.serviceMicros / 1000000.0;
+    return static_cast<size_t>(std::ceil(busy / policy.targetUtilization));
+}
+
+size_t Autoscaler::evaluate(const ScalingSignals& signals) {
+    auto now = std::chrono::steady_clock::now();
+    size_t required = requiredThreads(signals);
+    uint64_t latency = std::max(signals.queueWaitP99, signals.lagP99);
+
+    // 延迟超标，或按 Little 定律当前线程不足以在目标利用率下承载到达率
+    bool overloaded = latency > policy.targetLatencyMicros || required > signals.threads;
+    // 延迟远低于目标，且减少一个线程后利用率仍不超过目标
+    bool underloaded = latency < policy.idleLatencyMicros && required < signals.threads;
+
+    hotSamples = overloaded ? hotSamples + 1 : 0;
+    coldSamples = underloaded ? coldSamples + 1 : 0;
+
+    char reason[192];
+    snprintf(reason, sizeof(reason), "wait p99 %lluus, lag p99 %lluus, %0.0f/s x %0.1fus -> %zu threads at %0.0f%%",
+        static_cast<unsigned long long>(signals.queueWaitP99), static_cast<unsigned long long>(signals.lagP99),
+        signals.arrivalRate, signals.serviceMicros, required, policy.targetUtilization * 100);
+
+    if (signals.budgetSurplus > 0) {
+        // 其他线程池在份额之内借用了预算，按扩容冷却尽快归还，期间不再扩容
+        hotSamples = 0;
+        if (signals.threads <= minSize || now - lastChange < policy.growCooldown) {
+            return signals.threads;
+        }
+
+        size_t target = signals.threads - 1;
+
+        LOG_INFO("%s: Autoscale shrink %zu -> %zu: yield to thread budget (surplus %zu), %s", pool.c_str(), signals.threads, target, signals.budgetSurplus, reason);
+
+        coldSamples = 0;
+        lastChange = now;
+        return target;
+    }
+
+    if (hotSamples >= policy.growSamples) {
+        if (signals.threads >= maxSize) {
+            if (hotSamples == policy.growSamples) {
+                LOG_WARNING("%s: Autoscale hold at max %zu threads: %s", pool.c_str(), signals.threads, reason);
+            }
+            return signals.threads;
+        }
+        if (now - lastChange < policy.growCooldown) {
+            return signals.threads;
+        }
+
+        size_t step = std::clamp(required > signals.threads ? required - signals.threads : size_t(1), size_t(1), std::max(policy.maxGrowStep, size_t(1)));
+        size_t target = std::min(maxSize, signals.threads + step);
+
+        // 预算未批准时不算一次扩容：不写日志、不进入冷却，下一次评估仍过载时重新申请
+        size_t granted = ThreadBudget::getInstance()->acquire(pool, target - signals.threads);
+        if (granted == 0) {
+            return signals.threads;
+        }
+        target = signals.threads + granted;
+
+        LOG_INFO("%s: Autoscale grow %zu -> %zu: %s", pool.c_str(), signals.threads, target, reason);
+
+        hotSamples = 0;
+        lastChange = now;
+        return target;
+    }
+
+    if (coldSamples >= policy.shrinkSamples && signals.threads > minSize && now - lastChange >= policy.shrinkCooldown) {
+        // 一次只缩一个线程，观察效果后再继续
+        size_t target = signals.threads - 1;
+
+        LOG_INFO("%s: Autoscale shrink %zu -> %zu: %s", pool.c_str(), signals.threads, target, reason);
+
+        coldSamples = 0;
+        lastChange = now;
+        return target;
+    }
+
+    return signals.threads;
+}
+
+void Autoscaler::onResizeFailed(size_t target) {
+    LOG_WARNING("%s: Autoscale resize to %zu threads did not complete, retry after cooldown", pool.c_str(), target);
+
+    hotSamples = 0;
+    coldSamples = 0;
+    lastChange = std::chrono::steady_clock::now();
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 线程池一次评估的输入，均为上一个评估区间内的测量值
+struct ScalingSignals {
+    size_t threads = 0;
+    // 每秒完成的任务数（到达率的估计）
+    double arrivalRate = 0;
+    // 平均处理时间（微秒），无法测量时为 0
+    double serviceMicros = 0;
+    // 任务排队等待 p99（微秒），没有队列时为 0
+    uint64_t queueWaitP99 = 0;
+    // 事件循环调度延迟 p99（微秒）
+    uint64_t lagP99 = 0;
+    // 线程预算要求让出的线程数
+    size_t budgetSurplus = 0;
+};
+
+// 扩缩容参数，来自 config.ini 的 [Autoscale.<pool>] 节
+struct ScalingPolicy {
+    std::chrono::milliseconds interval{ 1000 };
+
+    // 排队等待或调度延迟 p99 超过该值视为过载
+    uint64_t targetLatencyMicros = 2000;
+
+    // 排队等待与调度延迟 p99 都低于该值才考虑缩容
+    uint64_t idleLatencyMicros = 200;
+
+    // 按 Little 定律估算所需线程数时的目标利用率
+    double targetUtilization = 0.7;
+
+    // 连续满足条件的评估次数，避免单次抖动触发扩缩容
+    int growSamples = 2;
+
+    int shrinkSamples = 10;
+
+    std::chrono::milliseconds growCooldown{ 3000 };
+
+    std::chrono::milliseconds shrinkCooldown{ 30000 };
+
+    // 单次扩容最多增加的线程数
+    size_t maxGrowStep = 2;
+
+    static ScalingPolicy load(const std::string& pool);
+};
+
+// 根据延迟与 Little 定律（繁忙线程数 = 到达率 × 处理时间）计算线程池目标大小
+// 扩容快、缩容慢：两个方向各有连续采样要求（滞回）与冷却时间，每次决定都带原因写日志
+// 只由线程池的监控线程调用，不加锁
+class Autoscaler {
+public:
+    Autoscaler(std::string pool, size_t minSize, size_t maxSize);
+
+    // 返回目标线程数，等于 signals.threads 表示保持；扩容时已向 ThreadBudget 申请，目标只包含批准的线程
+    size_t evaluate(const ScalingSignals& signals);
+
+    // 扩缩容未能完成（如缩容超时）时调用，按冷却时间推迟下一次尝试
+    void onResizeFailed(size_t target);
+
+    const ScalingPolicy& getPolicy() const { return policy; }
+
+private:
+    // Little 定律估算的线程数，处理时间未知时返回 0
+    size_t requiredThreads(const ScalingSignals& signals) const;
+
+    std::string pool;
+
+    ScalingPolicy policy;
+
+    size_t minSize;
+
+    size_t maxSize;
+
+    int hotSamples = 0;
+
+    int coldSamples = 0;
+
+    std::chrono::steady_clock::time_point lastChange;
+};
@@ -0,0 +1,166 @@
+#include "BufferPool.h"
+#include <new>
+
+namespace {
+
+    // 每个级别线程本地缓存的字节上限，至少缓存 2 个块
+    constexpr size_t THREAD_CACHE_BYTES = 1024 * 64;
+
+    size_t maxCachedBlocks(size_t blockSize) {
+        size_t count = THREAD_CACHE_BYTES / blockSize;
+        return count < 2 ? 2 : count;
+    }
+
+}
+
+// 线程本地缓存：分配/释放的常见路径无锁
+struct ThreadCache {
+    BufferPool::FreeBlock* heads[BufferPool::SIZE_CLASS_COUNT] = {};
+    size_t counts[BufferPool::SIZE_CLASS_COUNT] = {};
+
+    ~ThreadCache() {
+        // 线程退出时把缓存的块全部归还到中心链表
+        for (size_t i = 0; i < BufferPool::SIZE_CLASS_COUNT; i++) {
+            if (heads[i] == nullptr) continue;
+            BufferPool::FreeBlock* tail = heads[i];
+            while (tail->next != nullptr) tail = tail->next;
+            BufferPool::getInstance()->releaseBatch(i, heads[i], tail, counts[i]);
+            heads[i] = nullptr;
+            counts[i] = 0;
+        }
+    }
+};
+
+static thread_local ThreadCache threadCache;
+
+BufferPool::~BufferPool() {
+    std::lock_guard<std::mutex> lock(slabMutexs);
+    for (char* slab : slabs) {
+        ::operator delete(slab);
+    }
+    slabs.clear();
+}
+
+size_t BufferPool::sizeClassIndex(size_t size) {
+    size_t index = 0;
+    size_t blockSize = MIN_BLOCK_SIZE;
+    while (blockSize < size) {
+        blockSize <<= 1;
+        index++;
+    }
+    return index;
+}
+
+char* BufferPool::allocate(size_t size) {
+    if (!isPoolable(size)) {
+        return nullptr;
+    }
+
+    size_t index = sizeClassIndex(size);
+    FreeBlock* block = threadCache.heads[index];
+
+    if (block == nullptr) {
+        size_t fetched = 0;
+        block = fetchBatch(index, maxCachedBlocks(sizeClassBytes(index)) / 2 + 1, fetched);
+        if (block == nullptr) {
+            return nullptr;
+        }
+        threadCache.heads[index] = block;
+        threadCache.counts[index] = fetched;
+    }
+
+    threadCache.heads[index] = block->next;
+    threadCache.counts[index]--;
+    return reinterpret_cast<char*>(block);
+}
+
+void BufferPool::deallocate(char* data, size_t size) {
+    if (data == nullptr || !isPoolable(size)) {
+        return;
+    }
+
+    size_t index = sizeClassIndex(size);
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(data);
+    block->next = threadCache.heads[index];
+    threadCache.heads[index] = block;
+    threadCache.counts[index]++;
+
+    size_t limit = maxCachedBlocks(sizeClassBytes(index));
+    if (threadCache.counts[index] <= limit) {
+        return;
+    }
+
+    // 超过本地缓存上限：把一半归还到中心链表，供其他线程使用
+    size_t releaseCount = limit / 2 + 1;
+    FreeBlock* head = threadCache.heads[index];
+    FreeBlock* tail = head;
+    for (size_t i = 1; i < releaseCount; i++) {
+        tail = tail->next;
+    }
+    threadCache.heads[index] = tail->next;
+    threadCache.counts[index] -= releaseCount;
+    tail->next = nullptr;
+    releaseBatch(index, head, tail, releaseCount);
+}
+
+BufferPool::FreeBlock* BufferPool::fetchBatch(size_t index, size_t count, size_t& fetched) {
+    CentralList& central = centralLists[index];
+    {
+        std::lock_guard<std::mutex> lock(central.mutexs);
+        if (central.head != nullptr) {
+            FreeBlock* head = central.head;
+            FreeBlock* tail = head;
+            fetched = 1;
+            while (fetched < count && tail->next != nullptr) {
+                tail = tail->next;
+                fetched++;
+            }
+            central.head = tail->next;
+            central.count -= fetched;
+            tail->next = nullptr;
+            return head;
+        }
+    }
+
+    // 中心链表为空：申请一个新的 slab 并切分成块
+    size_t blockSize = sizeClassBytes(index);
+    size_t slabSize = blockSize > SLAB_SIZE ? blockSize : SLAB_SIZE;
+    char* slab = static_cast<char*>(::operator new(slabSize, std::nothrow));
+    if (slab == nullptr) {
+        fetched = 0;
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(slabMutexs);
+        slabs.push_back(slab);
+    }
+
+    size_t blocks = slabSize / blockSize;
+    for (size_t i = 0; i < blocks; i++) {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * blockSize);
+        block->next = (i + 1 < blocks) ? reinterpret_cast<FreeBlock*>(slab + (i + 1) * blockSize) : nullptr;
+    }
+
+    FreeBlock* head = reinterpret_cast<FreeBlock*>(slab);
+    if (blocks <= count) {
+        fetched = blocks;
+        return head;
+    }
+
+    // 多出来的块放入中心链表
+    FreeBlock* tail = reinterpret_cast<FreeBlock*>(slab + (count - 1) * blockSize);
+    FreeBlock* rest = tail->next;
+    FreeBlock* restTail = reinterpret_cast<FreeBlock*>(slab + (blocks - 1) * blockSize);
+    tail->next = nullptr;
+    releaseBatch(index, rest, restTail, blocks - count);
+    fetched = count;
+    return head;
+}
+
+void BufferPool::releaseBatch(size_t index, FreeBlock* head, FreeBlock* tail, size_t count) {
+    CentralList& central = centralLists[index];
+    std::lock_guard<std::mutex> lock(central.mutexs);
+    tail->next = central.head;
+    central.head = head;
+    central.count += count;
+}
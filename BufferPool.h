@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+
+// 按尺寸级别划分的内存池：64B ~ 64KB 共 11 个级别，每个线程持有本地缓存，
+// 本地缓存不足时从中心链表批量获取，中心链表不足时按 slab 批量向系统申请
+class BufferPool {
+public:
+    static BufferPool* getInstance() {
+        static BufferPool instance;
+        return &instance;
+    }
+
+    ~BufferPool();
+
+    BufferPool(const BufferPool& bufferPool) = delete;
+
+    BufferPool& operator=(const BufferPool& bufferPool) = delete;
+
+    // 超过最大级别时返回 nullptr，调用者应回退到 new[]
+    char* allocate(size_t size);
+
+    void deallocate(char* data, size_t size);
+
+    static bool isPoolable(size_t size) { return size <= MAX_BLOCK_SIZE; }
+
+    static constexpr size_t MIN_BLOCK_SIZE = 64;
+
+    static constexpr size_t MAX_BLOCK_SIZE = 1024 * 64;
+
+    static constexpr size_t SIZE_CLASS_COUNT = 11;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+private:
+    BufferPool() = default;
+
+    friend struct ThreadCache;
+
+    static size_t sizeClassIndex(size_t size);
+
+    static size_t sizeClassBytes(size_t index) { return MIN_BLOCK_SIZE << index; }
+
+    // 从中心链表批量取出最多 count 个块，必要时申请新的 slab
+    FreeBlock* fetchBatch(size_t index, size_t count, size_t& fetched);
+
+    // 将一串块归还到中心链表
+    void releaseBatch(size_t index, FreeBlock* head, FreeBlock* tail, size_t count);
+
+    struct CentralList {
+        std::mutex mutexs;
+        FreeBlock* head = nullptr;
+        size_t count = 0;
+    };
+
+    CentralList centralLists[SIZE_CLASS_COUNT];
+
+    std::mutex slabMutexs;
+
+    std::vector<char*> slabs;
+
+    static constexpr size_t SLAB_SIZE = 1024 * 256;
+};
@@ -1,70 +1,511 @@
 #include "CServer.h"
 #include "LogicSystem.h"
 #include "Utils.h"
+#include "NetworkMetrics.h"
+#include <unordered_map>
+#include <bit>
+#if defined(__linux__)
+#include <linux/filter.h>
+#include <sys/socket.h>
+#include <cerrno>
+#endif
 
 
 //tcp::v4()ʾյipΧ,portַ;
 CServer::CServer(boost::asio::io_context& ioContext, unsigned short& port,size_t size)
-	:c_ioContext(ioContext),c_accept(ioContext, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::any(), port))
-,sessions(size), sessionMutexs(size), hashSize(size){
+	:c_ioContext(ioContext),c_accept(ioContext)
+,sessions(size), connections(0){
 
 	LogicSystem::getInstance()->initializeThreads();
 
-	c_accept.set_option(boost::asio::ip::tcp::no_delay(true));
+	AsioProactors::getInstance()->setSessionMigrator([this](boost::asio::io_context& victim) {
 
-	startAccept();
+		migrateSessions(victim);
+
+		});
+
+	boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::address_v4::any(), port);
+
+	// config.ini [SelfServer] AcceptMode = single | reuseport
+	SectionInfo serverConfig = ConfigMgr::Inst()["SelfServer"];
+
+	socketProfile = SocketProfile::load(serverConfig["SocketProfile"]);
+
+	NetworkMetrics::getInstance()->setSocketProfile(socketProfile.describe());
+
+	if (serverConfig["AcceptMode"] == "reuseport" && startReusePortAcceptors(endpoint, serverConfig["ReusePortCpuSteering"] == "true")) {
+
+		return;
+
+	}
+
+	openAcceptor(c_accept, endpoint, false);
+
+	startAccept(c_accept, nullptr);
+}
+
+void CServer::openAcceptor(boost::asio::ip::tcp::acceptor& acceptor, const boost::asio::ip::tcp::endpoint& endpoint, bool reusePort)
+{
+	acceptor.open(endpoint.protocol());
+
+	acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+
+#ifdef SO_REUSEPORT
+	if (reusePort) {
+
+		acceptor.set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+
+	}
+#endif
+
+	acceptor.set_option(boost::asio::ip::tcp::no_delay(true));
+
+	acceptor.bind(endpoint);
+
+	acceptor.listen(boost::asio::socket_base::max_listen_connections);
 }
 
-void CServer::removeSession(std::string sessionId)
+bool CServer::startReusePortAcceptors(const boost::asio::ip::tcp::endpoint& endpoint, bool cpuSteering)
 {
-	LOG_WARNING("CServer::removeSession() sessionId: %s", sessionId.c_str());
+#if defined(__linux__) && defined(SO_REUSEPORT)
+	AsioProactors* proactors = AsioProactors::getInstance();
+	// ֻڳפ I/O ߳Ͻ̬ݵ̻߳ᱻݻ
+	size_t count = proactors->getBaseSize();
+
+	try {
+
+		for (size_t i = 0; i < count; i++) {
+
+			auto acceptor = std::make_unique<boost::asio::ip::tcp::acceptor>(proactors->getIoContext(i));
+
+			openAcceptor(*acceptor, endpoint, true);
+
+			acceptors.push_back(std::move(acceptor));
+
+		}
+	}
+	catch (const boost::system::system_error& e) {
 
-	size_t hashValue = std::hash<std::string>{}(sessionId);
+		LOG_WARNING("CServer: SO_REUSEPORT acceptors unavailable (%s), fall back to single acceptor", e.what());
 
-	hashValue = hashValue % this->hashSize;
+		acceptors.clear();
 
-	{
-		std::lock_guard<std::mutex> guard(this->sessionMutexs[hashValue]);
+		return false;
 
-		sessions[hashValue].erase(sessionId);
+	}
+
+	if (cpuSteering) {
+		// CBPF 򷵻صǰ CPU ŶԼȡģں˾ݴѡͬа˳еļ socket
+		struct sock_filter code[] = {
+			{ BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+			{ BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(count) },
+			{ BPF_RET | BPF_A, 0, 0, 0 },
+		};
+
+		struct sock_fprog program = { static_cast<unsigned short>(sizeof(code) / sizeof(code[0])), code };
+
+		if (setsockopt(acceptors.front()->native_handle(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) != 0) {
+
+			LOG_WARNING("CServer: SO_ATTACH_REUSEPORT_CBPF failed, errno: %d", errno);
+
+		}
+	}
+
+	for (size_t i = 0; i < acceptors.size(); i++) {
+
+		startAccept(*acceptors[i], &proactors->getIoContext(i));
+
+	}
+
+	LOG_INFO("CServer: %zu SO_REUSEPORT acceptors started, CPU steering: %s", acceptors.size(), cpuSteering ? "on" : "off");
+
+	return true;
+#else
+	LOG_WARNING("CServer: SO_REUSEPORT is not supported on this platform, fall back to single acceptor");
+
+	return false;
+#endif
+}
+
+void CServer::removeSession(uint64_t sessionId)
+{
+	LOG_WARNING("CServer::removeSession() sessionId: %016llx", static_cast<unsigned long long>(sessionId));
+
+	if (sessions.erase(sessionId)) {
 
 		connections--;
+
+	}
+
+}
+
+std::shared_ptr<CSession> CServer::findSession(uint64_t sessionId)
+{
+	return sessions.find(sessionId);
+}
+
+void CServer::broadcast(std::shared_ptr<const std::string> payload, short msgid)
+{
+	std::vector<std::shared_ptr<CSession>> targets = sessions.snapshot();
+
+	fanOut(targets, std::make_shared<SendNode>(std::move(payload), msgid));
+}
+
+void CServer::multicast(std::vector<std::shared_ptr<CSession>> targets, std::shared_ptr<const std::string> payload, short msgid)
+{
+	fanOut(targets, std::make_shared<SendNode>(std::move(payload), msgid));
+}
+
+void CServer::multicast(const std::vector<uint64_t>& sessionIds, std::shared_ptr<const std::string> payload, short msgid)
+{
+	std::vector<std::shared_ptr<CSession>> targets;
+
+	targets.reserve(sessionIds.size());
+
+	for (uint64_t sessionId : sessionIds) {
+
+		std::shared_ptr<CSession> session = sessions.find(sessionId);
+
+		if (session != nullptr) {
+
+			targets.push_back(std::move(session));
+
+		}
+	}
+
+	fanOut(targets, std::make_shared<SendNode>(std::move(payload), msgid));
+}
+
+void CServer::fanOut(std::vector<std::shared_ptr<CSession>>& targets, std::shared_ptr<SendNode> node)
+{
+	std::unordered_map<boost::asio::io_context*, std::vector<std::shared_ptr<CSession>>> groups;
+
+	for (auto& session : targets) {
+
+		if (session == nullptr) continue;
+
+		groups[&session->getIoContext()].push_back(std::move(session));
+
 	}
 
+	for (auto& pair : groups) {
+
+		boost::asio::post(*pair.first, [node, group = std::move(pair.second)]() {
+
+			for (const auto& session : group) {
+
+				session->writeAsync(node);
+
+			}
+
+			});
+	}
 }
 
+void CServer::drain(std::chrono::milliseconds timeout)
+{
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+
+	LOG_INFO("CServer::drain start, sessions: %zu, timeout: %lld ms", sessions.size(), static_cast<long long>(timeout.count()));
+
+	draining.store(true);
+
+	// 1. ֹͣӣacceptor ֻ߳Ϲر
+	auto closeAcceptor = [](boost::asio::ip::tcp::acceptor& acceptor) {
+
+		boost::asio::post(acceptor.get_executor(), [&acceptor]() {
+
+			boost::system::error_code ec;
+
+			acceptor.close(ec);
+
+			});
+	};
+
+	closeAcceptor(c_accept);
+
+	for (auto& acceptor : acceptors) {
+
+		closeAcceptor(*acceptor);
+
+	}
+
+	// 2. ֹͣȡ֮󲻻Ϣ LogicSystem
+	sessions.forEach([](const std::shared_ptr<CSession>& session) {
+
+		session->stopReading();
 
-void CServer::startAccept() {
+		});
+
+	// 3. ȴ LogicSystem ӵϢӦỰͶ
+	LogicSystem::getInstance()->drain(deadline);
+
+	// 4. д귢Ͷ
+	size_t queuedBytes = 0;
+
+	for (;;) {
+
+		queuedBytes = 0;
+
+		sessions.forEach([&queuedBytes](const std::shared_ptr<CSession>& session) {
+
+			if (!session->isStop.load()) queuedBytes += session->getQueuedBytes();
+
+			});
+
+		if (queuedBytes == 0 || std::chrono::steady_clock::now() >= deadline) break;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	}
+
+	if (queuedBytes > 0) {
+
+		LOG_WARNING("CServer::drain deadline exceeded, %zu bytes unsent", queuedBytes);
+
+	}
+
+	// 5. رȫỰ
+	for (auto& session : sessions.snapshot()) {
+
+		session->close();
+
+	}
+
+	LOG_INFO("CServer::drain finished");
+}
+
+void CServer::migrateSessions(boost::asio::io_context& victim)
+{
+	sessions.forEach([&victim](const std::shared_ptr<CSession>& session) {
+
+		if (&session->getIoContext() != &victim) return;
+
+		boost::asio::io_context& target = AsioProactors::getInstance()->getIoComplatePorts();
+
+		boost::asio::co_spawn(victim, [session, &target]() -> boost::asio::awaitable<void> {
+
+			co_await session->migrate(target);
+
+			}, boost::asio::detached);
+
+		});
+}
+
+void CServer::rejectConnection(boost::asio::ip::tcp::socket& socket, AdmissionResult result)
+{
+	bool rateLimited = result == AdmissionResult::REJECTED_RATE;
+
+	NetworkMetrics::getInstance()->recordConnectionRejected(rateLimited);
+
+	boost::system::error_code ec;
+
+	if (admission.sendBusyFrame()) {
+		// δЭЭ飬ʹ LEGACY ϢͷϢΪܾԭ1 ޣ2 
+		char frame[HEAD_TOTAL_LEN + 1];
+
+		FrameCodec::encodeLegacyHeader(frame, static_cast<short>(SERVER_BUSY_ID), 1);
+
+		frame[HEAD_TOTAL_LEN] = rateLimited ? 2 : 1;
+
+		socket.non_blocking(true, ec);
+
+		socket.write_some(boost::asio::buffer(frame, sizeof(frame)), ec);
+
+	}
+
+	socket.close(ec);
+}
+
+void CServer::handoffAccepted(boost::asio::ip::tcp::socket& peer)
+{
+	boost::system::error_code ec;
+
+	boost::asio::ip::tcp::endpoint endpoint = peer.local_endpoint(ec);
+
+	boost::asio::ip::tcp::socket::native_handle_type handle = ec ? boost::asio::ip::tcp::socket::native_handle_type() : peer.release(ec);
+
+	if (ec) {
+
+		LOG_ERROR("CServer failed to release accepted socket: %s", ec.message().c_str());
+
+		peer.close(ec);
+
+		connections--;
+
+		return;
+
+	}
+
+	boost::asio::io_context& ioContext = AsioProactors::getInstance()->getIoComplatePorts();
+
+	std::shared_ptr<CSession> session = std::make_shared<CSession>(ioContext, this);
+
+	boost::asio::ip::tcp protocol = endpoint.protocol();
+
+	AsioProactors::getInstance()->handoff(ioContext, [this, session, protocol, handle]() {
+
+		boost::system::error_code ec;
+
+		session->getSocket().assign(protocol, handle, ec);
+
+		if (ec) {
+
+			LOG_ERROR("CServer failed to adopt accepted socket: %s", ec.message().c_str());
+
+			boost::asio::detail::socket_ops::state_type state = 0;
+
+			boost::asio::detail::socket_ops::close(handle, state, true, ec);
+
+			connections--;
+
+			return;
+
+		}
+
+		onAccepted(session);
+
+		});
+}
+
+void CServer::onAccepted(std::shared_ptr<CSession> session)
+{
+	if (socketProfile.enabled()) {
+
+		uint32_t failures = socketProfile.apply(session->getSocket());
+
+		NetworkMetrics::getInstance()->recordSocketProfileApplied(std::popcount(failures));
+
+		// ͬһѡͨӶʧܣֻ״ʧʱ棬 NetworkMetrics
+		uint32_t fresh = failures & ~reportedSocketFailures.fetch_or(failures);
+
+		if (fresh != 0) {
+
+			LOG_WARNING("CServer: socket options of profile %s failed: %s", socketProfile.name.c_str(), SocketProfile::optionNames(fresh).c_str());
+
+		}
+
+	}
+
+	// connections ׼ʱ
+	sessions.insert(session);
+
+	session->start();
+
+	//  drain() ʱ֤»ỰҲֹͣȡ
+	if (draining.load()) {
+
+		session->stopReading();
+
+	}
+}
+
+void CServer::startAccept(boost::asio::ip::tcp::acceptor& acceptor, boost::asio::io_context* sessionContext) {
 
 	LOG_INFO("CServer::startAccept");
 
-	boost::asio::co_spawn(c_ioContext, [this]() ->boost::asio::awaitable<void> {
+	boost::asio::co_spawn(acceptor.get_executor(), [this, &acceptor, sessionContext]() ->boost::asio::awaitable<void> {
+
+		boost::asio::steady_timer backoffTimer(acceptor.get_executor());
+
+		std::chrono::milliseconds errorBackoff(10);
 
 		for (;;) {
-			boost::asio::io_context& ioContext = AsioProactors::getInstance()->getIoComplatePorts();
+			// LogicSystem ѹʱֹͣܣں˼
+			if (admission.shouldPauseAccept()) {
 
-			std::shared_ptr<CSession> session = std::make_shared<CSession>(ioContext, this);
+				backoffTimer.expires_after(std::chrono::milliseconds(50));
+
+				co_await backoffTimer.async_wait(boost::asio::use_awaitable);
+
+				continue;
+
+			}
 
-			co_await c_accept.async_accept(session->getSocket(), boost::asio::use_awaitable);
+			// UNSAFE_IO ģʽ socket ֻ߳עᣬȽܵڵ io_contextٰѾƽỰ߳
+			bool handoffAccept = sessionContext == nullptr && AsioProactors::getInstance()->getConcurrencyMode() == ConcurrencyMode::UNSAFE_IO;
 
-			//std::cout << "Session Async_accpet IP: " << session->getSocket().remote_endpoint().address().to_v4().to_string() << ":" << session->getSocket().remote_endpoint().port() << std::endl;
+			// ģʽ»Ựͬһ io_context򰴸ѡ
+			boost::asio::io_context* ioContext = handoffAccept ? nullptr : (sessionContext ? sessionContext : &AsioProactors::getInstance()->getIoComplatePorts());
 
-			size_t hashValue = std::hash<std::string>{}(session->getSessionId());
+			boost::asio::ip::tcp::socket peer = handoffAccept ? boost::asio::ip::tcp::socket(acceptor.get_executor()) : boost::asio::ip::tcp::socket(*ioContext);
 
-			hashValue = hashValue % this->hashSize;
+			boost::system::error_code ec;
 
-			{
-				std::lock_guard<std::mutex> guard(this->sessionMutexs[hashValue]);
+			co_await acceptor.async_accept(peer, boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+
+			if (ec == boost::asio::error::operation_aborted || draining.load()) {
+
+				co_return;
 
-				sessions[hashValue].insert(std::pair<std::string, std::shared_ptr<CSession>>(session->getSessionId(), session));
 			}
 
-			connections++;
+			if (ec) {
+				// fd ڴľʱ˱ԣ accept æѭ
+				NetworkMetrics::getInstance()->recordAcceptError();
+
+				LOG_ERROR("CServer accept error: %s, retry in %lld ms", ec.message().c_str(), static_cast<long long>(errorBackoff.count()));
+
+				backoffTimer.expires_after(errorBackoff);
+
+				co_await backoffTimer.async_wait(boost::asio::use_awaitable);
+
+				errorBackoff = std::min(errorBackoff * 2, std::chrono::milliseconds(1000));
+
+				continue;
 
-			session->start();
+			}
+
+			errorBackoff = std::chrono::milliseconds(10);
+
+			//std::cout << "Session Async_accpet IP: " << peer.remote_endpoint().address().to_v4().to_string() << ":" << peer.remote_endpoint().port() << std::endl;
+
+			AdmissionResult result = admission.tryAdmit(connections);
+
+			if (result != AdmissionResult::ACCEPTED) {
+
+				rejectConnection(peer, result);
+
+				continue;
+
+			}
+
+			if (handoffAccept) {
+
+				handoffAccepted(peer);
+
+				continue;
+
+			}
+
+			if (!AsioProactors::getInstance()->isActive(*ioContext)) {
+				// ȴ accept ڼѡ io_context ݣӻе io_context 
+				ioContext = &AsioProactors::getInstance()->getIoComplatePorts();
+
+				boost::asio::ip::tcp::endpoint endpoint = peer.local_endpoint(ec);
+
+				boost::asio::ip::tcp::socket::native_handle_type handle = ec ? boost::asio::ip::tcp::socket::native_handle_type() : peer.release(ec);
+
+				if (!ec) peer = boost::asio::ip::tcp::socket(*ioContext, endpoint.protocol(), handle);
+
+				if (ec) {
+
+					LOG_ERROR("CServer failed to move accepted socket: %s", ec.message().c_str());
+
+					connections--;
+
+					continue;
+
+				}
+			}
+
+			std::shared_ptr<CSession> session = std::make_shared<CSession>(*ioContext, this);
+
+			session->getSocket() = std::move(peer);
+
+			onAccepted(session);
 			
 		}
-
 		}, [](std::exception_ptr p) {
 
 			if (p) {
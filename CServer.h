@@ -6,29 +6,76 @@
 #include <string>
 #include <map>
 #include "CSession.h"
+#include "SessionRegistry.h"
+#include "SocketOptions.h"
+#include "AdmissionControl.h"
 
 class CServer{
 public:
 
 	CServer(boost::asio::io_context &ioContext,unsigned short& port,size_t size = 1024);
 
-	void removeSession(std::string sessionId);
+	void removeSession(uint64_t sessionId);
+
+	// Ự ID һỰڷ͵·
+	std::shared_ptr<CSession> findSession(uint64_t sessionId);
+
+	// лỰ㲥ϢֻһΣнշķͶйͬһֻ SendNode
+	void broadcast(std::shared_ptr<const std::string> payload, short msgid);
+
+	// ָỰϷֻͣͬһϢ
+	void multicast(std::vector<std::shared_ptr<CSession>> targets, std::shared_ptr<const std::string> payload, short msgid);
+
+	void multicast(const std::vector<uint64_t>& sessionIds, std::shared_ptr<const std::string> payload, short msgid);
+
+	// Źرգֹͣȡȴ LogicSystem ѹϢдỰķͶкرջỰ
+	// ã I/O ִ߳
+	void drain(std::chrono::milliseconds timeout);
 
 private:
 
-	void startAccept();
+	//  acceptor ѭӣsessionContext Ϊʱ AsioProactors ѡỰڵ io_context
+	void startAccept(boost::asio::ip::tcp::acceptor& acceptor, boost::asio::io_context* sessionContext);
+
+	// ܾӣԷʽдæ֡ر
+	void rejectConnection(boost::asio::ip::tcp::socket& socket, AdmissionResult result);
+
+	//  victim ϵĻỰǨƵ io_context AsioProactors ʱ
+	void migrateSessions(boost::asio::io_context& victim);
+
+	// UNSAFE_IO ģʽͷż߳ϽܵľڻỰ߳עỰ
+	void handoffAccepted(boost::asio::ip::tcp::socket& peer);
+
+	// ӽܺͳһ
+	void onAccepted(std::shared_ptr<CSession> session);
+
+	void openAcceptor(boost::asio::ip::tcp::acceptor& acceptor, const boost::asio::ip::tcp::endpoint& endpoint, bool reusePort);
+
+	// SO_REUSEPORT ģʽÿפ I/O ߳ӵжļ socket
+	bool startReusePortAcceptors(const boost::asio::ip::tcp::endpoint& endpoint, bool cpuSteering);
+
+	// Ự io_context 飬ÿͶݵӦ I/O ִ߳
+	void fanOut(std::vector<std::shared_ptr<CSession>>& targets, std::shared_ptr<SendNode> node);
 
 	//նԶ˵;
 	boost::asio::ip::tcp::acceptor c_accept;
 	//
 	boost::asio::io_context& c_ioContext;
+
+	std::vector<std::unique_ptr<boost::asio::ip::tcp::acceptor>> acceptors;
 	//socketնԶϢ;
 
-	std::vector<std::map<std::string, std::shared_ptr<CSession>>> sessions;
+	SessionRegistry sessions;
+
+	// ܵͳһʹõ socket 
+	SocketProfile socketProfile;
+
+	// Ѽ¼ʧѡλÿѡֻһ
+	std::atomic<uint32_t> reportedSocketFailures{ 0 };
 
-	std::vector<std::mutex> sessionMutexs;
+	AdmissionControl admission;
 
-	size_t hashSize;
+	std::atomic<bool> draining{ false };
 
 	std::atomic<size_t> connections;
 };
\ No newline at end of file
@@ -1,24 +1,55 @@
 #include "CSession.h"
 #include "CServer.h"
 #include "LogicSystem.h"
-#include <boost/uuid/uuid.hpp>            // uuid 类  
-#include <boost/uuid/uuid_generators.hpp> // 生成器  
-#include <boost/uuid/uuid_io.hpp>   
+#include <random>
+#include <cinttypes>
 #include "SessionSendThread.h"
 #include "FastMemcpy_Avx.h"
 #include <sstream>
 #include "Utils.h"
+#include "NetworkMetrics.h"
 
 
 CSession::CSession(boost::asio::io_context& ioContext, CServer* cserver) :socket(ioContext)
-, context(ioContext), server(cserver), isStop(false), writeChannel(ioContext, 1) {
+, context(&ioContext), timingWheel(&TimingWheel::of(ioContext)), server(cserver), isStop(false), writableChannel(ioContext, 1) {
 
-	boost::uuids::random_generator generator;
+	currentChannel = std::make_unique<WriteChannel>(ioContext, 1);
 
-	boost::uuids::uuid uuids = generator();
+	writeChannel.store(currentChannel.get());
 
-	sessionID = boost::uuids::to_string(uuids);
+	sessionID = nextSessionId();
 
+	load = AsioProactors::getInstance()->getLoad(ioContext);
+
+	frameTimer.onExpire = [this]() { onDeadline(frameDeadline); };
+
+	idleTimer.onExpire = [this]() { onDeadline(SessionDeadline::IDLE); };
+
+	heartbeatTimer.onExpire = [this]() { onDeadline(SessionDeadline::HEARTBEAT); };
+
+}
+
+// 会话 ID：进程启动时取一次随机种子，之后对递增计数做 splitmix64 混淆。
+// 混淆函数是双射，计数不重复则 ID 不重复；跳过 0 与全 1（会话表保留值）
+uint64_t CSession::nextSessionId() {
+
+    static const uint64_t seed = std::random_device{}() * 0x9E3779B97F4A7C15ULL;
+
+    static std::atomic<uint64_t> counter{ 0 };
+
+    for (;;) {
+
+        uint64_t value = seed + counter.fetch_add(1, std::memory_order_relaxed) * 0x9E3779B97F4A7C15ULL;
+
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+
+        value = value ^ (value >> 31);
+
+        if (value != 0 && value != UINT64_MAX) return value;
+
+    }
 }
 
 CSession::~CSession() {
@@ -27,77 +58,183 @@ CSession::~CSession() {
 
 }
 
+const SessionConfig& SessionConfig::get() {
+
+    static const SessionConfig config = []() {
+
+        SessionConfig config;
+
+        SectionInfo section = ConfigMgr::Inst()["Session"];
+
+        auto readValue = [&section](const std::string& key, auto defaultValue) {
+
+            std::string value = section[key];
+
+            return value.empty() ? defaultValue : static_cast<decltype(defaultValue)>(std::stoull(value));
+
+        };
+
+        config.maxBodyLength = readValue("MaxBodyLength", config.maxBodyLength);
+
+        config.sendQueueHighBytes = readValue("SendQueueHighBytes", config.sendQueueHighBytes);
+
+        config.sendQueueLowBytes = readValue("SendQueueLowBytes", config.sendQueueHighBytes / 2);
+
+        config.sendQueueHighCount = readValue("SendQueueHighCount", config.sendQueueHighCount);
+
+        config.sendQueueLowCount = readValue("SendQueueLowCount", config.sendQueueHighCount / 2);
+
+        config.recvQueueHigh = readValue("RecvQueueHigh", config.recvQueueHigh);
+
+        config.recvQueueLow = readValue("RecvQueueLow", config.recvQueueHigh / 2);
+
+        config.sessionRecvQueueHigh = readValue("SessionRecvQueueHigh", config.sessionRecvQueueHigh);
+
+        config.sessionRecvQueueLow = readValue("SessionRecvQueueLow", config.sessionRecvQueueHigh / 2);
+
+        config.enableProtocolV2 = section["ProtocolV2"] != "false";
+
+        config.headerTimeoutMs = readValue("HeaderTimeoutMs", config.headerTimeoutMs);
+
+        config.bodyTimeoutMs = readValue("BodyTimeoutMs", config.bodyTimeoutMs);
+
+        config.idleTimeoutMs = readValue("IdleTimeoutMs", config.idleTimeoutMs);
+
+        config.heartbeatTimeoutMs = readValue("HeartbeatTimeoutMs", config.heartbeatTimeoutMs);
+
+        std::string policy = section["SendQueuePolicy"];
+
+        if (policy == "drop_newest") config.sendQueuePolicy = SendQueuePolicy::DROP_NEWEST;
+
+        else if (policy == "drop_oldest") config.sendQueuePolicy = SendQueuePolicy::DROP_OLDEST;
+
+        else if (policy == "backpressure") config.sendQueuePolicy = SendQueuePolicy::BACKPRESSURE;
+
+        else if (policy == "disconnect") config.sendQueuePolicy = SendQueuePolicy::DISCONNECT;
+
+        else config.sendQueuePolicy = SendQueuePolicy::UNBOUNDED;
+
+        return config;
+
+    }();
+
+    return config;
+
+}
+
 void CSession::start() {
 
 	writerCoroutineAsync(); // 使用异步版本
 
+    if (ContextLoad* contextLoad = load.load()) contextLoad->sessions.fetch_add(1, std::memory_order_relaxed);
+
+    readerCoroutineAsync();
+}
+
+void CSession::readerCoroutineAsync() {
+
     auto self = shared_from_this();
 
-    boost::asio::co_spawn(context, [self]() -> boost::asio::awaitable<void> {
+    boost::asio::co_spawn(getIoContext(), [self]() -> boost::asio::awaitable<void> {
+
+        // 接收缓冲区：一次大块读取，尽可能解析出多个完整帧，只保留不完整的尾部
+        // 在所属 I/O 线程上分配并清零，按首次访问原则落在该线程绑定的 NUMA 节点上；迁移后保留尚未解析的数据
+        std::unique_ptr<char[]> buffer = std::make_unique<char[]>(RECV_BUFFER_SIZE);
+
+        size_t leftover = self->recvEnd - self->recvStart;
+
+        if (leftover > 0) std::memcpy(buffer.get(), self->recvBuffer.get() + self->recvStart, leftover);
+
+        self->recvBuffer = std::move(buffer);
+
+        self->recvStart = 0;
+
+        self->recvEnd = leftover;
 
-        char headerBuffer[HEAD_TOTAL_LEN];
+        const SessionConfig& config = SessionConfig::get();
 
-        size_t headerSize = sizeof(short) + sizeof(int64_t);
+        self->readerRunning = true;
+
+        // 协程结束（包括异常退出）时从时间轮上摘除全部定时器
+        struct ReaderGuard {
+            CSession* session;
+            ~ReaderGuard() {
+                session->cancelDeadlines();
+                session->readerParked = false;
+                session->readerRunning = false;
+                session->wakeMigration();
+            }
+        } readerGuard{ self.get() };
+
+        self->armDeadline(self->idleTimer, config.idleTimeoutMs);
+
+        self->armDeadline(self->heartbeatTimer, config.heartbeatTimeoutMs);
 
         try {
-            while (!self->isStop.load()) {
+            while (!self->isStop.load() && !self->readStopped.load() && !self->migrating) {
 
-                std::memset(headerBuffer, 0, headerSize);
-                // 接收消息头
-                size_t headerRead = 0;
+                // 解析缓冲区内所有完整的消息帧
+                while (self->recvEnd > self->recvStart) {
 
-                while (headerRead < headerSize) {
+                    char* frame = self->recvBuffer.get() + self->recvStart;
 
-                    size_t n = co_await self->socket.async_read_some(
-                        boost::asio::buffer(headerBuffer + headerRead, headerSize - headerRead),
-                        boost::asio::use_awaitable);
+                    size_t buffered = self->recvEnd - self->recvStart;
 
-                    if (n == 0) {
+                    FrameHeader header;
 
-                        self->close();
+                    DecodeResult result = FrameCodec::decodeHeader(self->recvVersion, frame, buffered, header);
 
-                        co_return;
+                    if (result == DecodeResult::NEED_MORE) {
+                        // 消息头不完整，等待下一次读取
+                        break;
                     }
 
-                    headerRead += n;
-                }
-                // 解析消息头
-                short rawMsgId = 0;
+                    if (result == DecodeResult::INVALID || header.length < 0
+                        || static_cast<uint64_t>(header.length) > SessionConfig::get().maxBodyLength) {
+                        // 拒绝非法或超长的消息体长度，避免恶意长度字段触发巨量分配
+                        LOG_ERROR("Invalid body length: %lld, Session: %s", static_cast<long long>(header.length), self->getSessionIdString().c_str());
 
-                int64_t rawBodyLength = 0;
+                        self->close();
 
-                std::memcpy(&rawMsgId, headerBuffer, sizeof(short));
+                        co_return;
+                    }
 
-                std::memcpy(&rawBodyLength, headerBuffer + sizeof(short), sizeof(int64_t));
+                    size_t bodySize = static_cast<size_t>(header.length);
 
-                short msgId = boost::asio::detail::socket_ops::network_to_host_short(rawMsgId);
+                    size_t available = buffered - header.headerLength;
 
-                int64_t bodyLength = boost::asio::detail::socket_ops::network_to_host_long(rawBodyLength);
-                // 🔧 关键修复4：使用 RAII 智能指针管理内存
-                size_t bodySize = static_cast<size_t>(bodyLength);
+                    if (available < bodySize && bodySize <= RECV_BUFFER_SIZE - header.headerLength) {
+                        // 不完整的小帧，等待下一次读取
+                        break;
+                    }
 
-                char* bodyBuffer = new char[bodySize];
+                    if (header.id == PROTOCOL_NEGOTIATE_ID && self->recvVersion == ProtocolVersion::LEGACY && available >= bodySize) {
+                        // 协议协商帧在 I/O 线程内直接处理，不进入 LogicSystem
+                        self->negotiateProtocol(frame + header.headerLength, bodySize);
 
-                if (!bodyBuffer) {
+                        self->recvStart += header.headerLength + bodySize;
 
-					LOG_ERROR("Failed to allocate body buffer of size: %zu", bodySize);
+                        TimingWheel::cancel(self->frameTimer);
 
-                    self->close();
+                        continue;
+                    }
 
-                    co_return;
+                    if (header.id == HEARTBEAT_ID && available >= bodySize) {
+                        // 心跳帧在 I/O 线程内直接应答，只刷新心跳超时，不计入业务消息
+                        self->writeAsync(std::make_shared<SendNode>(std::make_shared<const std::string>(), static_cast<short>(HEARTBEAT_ID)));
 
-                }
+                        self->recvStart += header.headerLength + bodySize;
 
-                // 接收消息体
-                size_t bodyRead = 0;
+                        TimingWheel::cancel(self->frameTimer);
 
-                while (bodyRead < bodySize) {
+                        continue;
+                    }
+
+                    std::shared_ptr<MessageNode> node = std::make_shared<MessageNode>(static_cast<int64_t>(header.headerLength));
 
-                    size_t n = co_await self->socket.async_read_some(
-                        boost::asio::buffer(bodyBuffer + bodyRead, bodySize - bodyRead),
-                        boost::asio::use_awaitable);
+                    if (!node->allocateData(bodySize)) {
 
-                    if (n == 0) {
+                        LOG_ERROR("Failed to allocate body buffer of size: %zu", bodySize);
 
                         self->close();
 
@@ -105,44 +242,116 @@ void CSession::start() {
 
                     }
 
-                    bodyRead += n;
+                    node->id = header.id;
+
+                    node->length = header.length;
+
+                    node->flags = header.flags;
+
+                    node->requestId = header.requestId;
+
+                    node->session = self;
+
+                    if (available >= bodySize) {
+
+                        std::memcpy(node->data, frame + header.headerLength, bodySize);
+
+                        self->recvStart += header.headerLength + bodySize;
+
+                    }
+                    else {
+                        // 超过接收缓冲区的大帧：拷贝已收到的部分，剩余部分直接读入消息体
+                        std::memcpy(node->data, frame + header.headerLength, available);
+
+                        self->recvStart = 0;
+
+                        self->recvEnd = 0;
 
+                        self->frameDeadline = SessionDeadline::BODY;
+
+                        self->armDeadline(self->frameTimer, config.bodyTimeoutMs);
+
+                        co_await boost::asio::async_read(self->socket,
+                            boost::asio::buffer(node->data + available, bodySize - available),
+                            boost::asio::use_awaitable);
+
+                        if (ContextLoad* contextLoad = self->load.load()) contextLoad->bytes.fetch_add(bodySize - available, std::memory_order_relaxed);
+
+                        self->armDeadline(self->heartbeatTimer, config.heartbeatTimeoutMs);
+                    }
+
+                    TimingWheel::cancel(self->frameTimer);
+
+                    self->armDeadline(self->idleTimer, config.idleTimeoutMs);
+
+                    LogicSystem::getInstance()->postMessageToQueue(node);
                 }
 
-                std::shared_ptr<MessageNode> node;
+                // LogicSystem 积压过多时暂停读取，由 TCP 接收窗口向发送方施加背压
+                if (self->shouldPauseReading()) {
+                    // 暂停期间客户端的数据无法被读取，不应计入读超时
+                    self->cancelDeadlines();
 
-                try {
+                    co_await self->waitReadable();
 
-                    node = std::make_shared<MessageNode>(HEAD_TOTAL_LEN);
+                    self->armDeadline(self->idleTimer, config.idleTimeoutMs);
 
-                    node->data = bodyBuffer;  
+                    self->armDeadline(self->heartbeatTimer, config.heartbeatTimeoutMs);
 
-                    node->id = msgId;
+                }
 
-                    node->length = bodyLength;
+                // 将不完整的帧移动到缓冲区头部
+                if (self->recvStart == self->recvEnd) {
 
-                    node->bufferSize = bodySize;
+                    self->recvStart = 0;
 
-                    node->session = self;
+                    self->recvEnd = 0;
 
                 }
-                catch (const std::exception& e) {
+                else if (self->recvStart > 0) {
 
-					LOG_ERROR("Failed to create MessageNode: %s", e.what());
-          
-                    continue;
+                    std::memmove(self->recvBuffer.get(), self->recvBuffer.get() + self->recvStart, self->recvEnd - self->recvStart);
+
+                    self->recvEnd -= self->recvStart;
+
+                    self->recvStart = 0;
 
                 }
 
-                LogicSystem::getInstance()->postMessageToQueue(node);
+                // 不完整帧的超时从该帧开始接收时计算，后续零散到达的字节不会延长期限
+                self->updateFrameDeadline();
+
+                self->readerParked = true;
+
+                size_t n = co_await self->socket.async_read_some(
+                    boost::asio::buffer(self->recvBuffer.get() + self->recvEnd, RECV_BUFFER_SIZE - self->recvEnd),
+                    boost::asio::bind_cancellation_slot(self->readCancel.slot(), boost::asio::use_awaitable));
+
+                self->readerParked = false;
+
+                if (n == 0) {
+
+                    self->close();
+
+                    co_return;
+                }
+
+                self->recvEnd += n;
+
+                if (ContextLoad* contextLoad = self->load.load()) contextLoad->bytes.fetch_add(n, std::memory_order_relaxed);
+
+                self->armDeadline(self->heartbeatTimer, config.heartbeatTimeoutMs);
             }
         }
         catch (const std::exception& e) {
+            // 优雅关闭或迁移时读操作被取消，会话保持打开
+            if (!self->readStopped.load() && !self->migrating) {
 
-			LOG_ERROR("Exception in CSession::start: %s", e.what());
+                LOG_ERROR("Exception in CSession::start: %s", e.what());
 
-            self->close();
+                self->close();
 
+            }
         }
 
         }, [this](std::exception_ptr p) {
@@ -157,13 +366,13 @@ void CSession::start() {
                     if (e.code() == boost::asio::error::eof ||
                         e.code() == boost::asio::error::connection_reset) {
 
-                        LOG_INFO("Client disconnected: %s, Session: %s", e.what(), sessionID.c_str());
+                        LOG_INFO("Client disconnected: %s, Session: %s", e.what(), getSessionIdString().c_str());
 
                     }
                     else {
 
                         LOG_ERROR("CSession coroutine error: %s (Code: %d), Session: %s",
-                            e.what(), e.code().value(), sessionID.c_str());
+                            e.what(), e.code().value(), getSessionIdString().c_str());
 
                     }
 
@@ -175,7 +384,7 @@ void CSession::start() {
                 }
                 catch (const std::exception& e) {
 
-                    LOG_ERROR("CSession coroutine std::exception: %s, Session: %s", e.what(), sessionID.c_str());
+                    LOG_ERROR("CSession coroutine std::exception: %s, Session: %s", e.what(), getSessionIdString().c_str());
 
                     if (this && !this->isStop.load()) {
 
@@ -188,7 +397,7 @@ void CSession::start() {
                 }
                 catch (...) {
 
-                    LOG_ERROR("CSession coroutine unknown exception, Session: %s", sessionID.c_str());
+                    LOG_ERROR("CSession coroutine unknown exception, Session: %s", getSessionIdString().c_str());
 
                     if (this && !this->isStop.load()) {
 
@@ -203,55 +412,157 @@ void CSession::start() {
             });
 }
 
-void CSession::writeAsync(char* msg, int64_t max_length, short msgid)
+SendResult CSession::writeAsync(char* msg, int64_t max_length, short msgid)
 {
     try {
 
-        std::shared_ptr<SendNode> nowNode = std::make_shared<SendNode>(msg, max_length, msgid);
+        return writeAsync(std::make_shared<SendNode>(msg, max_length, msgid));
 
-        if (nowNode) {
+    }
+    catch (std::exception& e) {
 
-            if (this->sendNodes.enqueue(nowNode)) {
+        LOG_ERROR("CSession::writeAsync ERROR: %s", e.what());
 
-                writeChannel.try_send(boost::system::error_code{});
+    }
 
-                nowNode = nullptr;
+    return SendResult::DROPPED;
+}
 
-            }
+SendResult CSession::writeAsync(std::string msg, short msgid)
+{
+    try {
+ 
+        if (msg.size() >= ZERO_COPY_THRESHOLD || msg.empty()) {
+            // 大消息直接接管字符串缓冲区，避免用户态拷贝
+            return writeAsync(std::make_shared<const std::string>(std::move(msg)), msgid);
 
         }
+        else {
+
+            return writeAsync(std::make_shared<SendNode>(msg.c_str(), static_cast<int64_t>(msg.size()), msgid));
 
+        }
     }
     catch (std::exception& e) {
 
-        LOG_ERROR("CSession::writeAsync ERROR: %s", e.what());
+        LOG_ERROR("CSession::writeAsync (std::string) ERROR: %s", e.what());
 
     }
+
+    return SendResult::DROPPED;
 }
 
-void CSession::writeAsync(std::string msg, short msgid)
+SendResult CSession::writeAsync(std::shared_ptr<const std::string> payload, short msgid)
 {
     try {
- 
-        std::shared_ptr<SendNode> nowNode = std::make_shared<SendNode>(msg.c_str(), static_cast<int64_t>(msg.size()), msgid);
 
-        if (nowNode) {
+        return writeAsync(std::make_shared<SendNode>(std::move(payload), msgid));
+
+    }
+    catch (std::exception& e) {
+
+        LOG_ERROR("CSession::writeAsync (shared payload) ERROR: %s", e.what());
+
+    }
+
+    return SendResult::DROPPED;
+}
+
+SendResult CSession::writeAsync(std::shared_ptr<SendNode> node)
+{
+    if (node == nullptr) return SendResult::DROPPED;
+
+    if (isStop.load()) return SendResult::CLOSED;
+
+    const SessionConfig& config = SessionConfig::get();
+
+    size_t nodeSize = node->totalSize();
+
+    if (config.sendQueuePolicy != SendQueuePolicy::UNBOUNDED && !isControlFrame(*node) && (queuedNodes.load() + 1 > config.sendQueueHighCount || queuedBytes.load() + nodeSize > config.sendQueueHighBytes)) {
+        // 发送队列超过高水位，按配置的策略处理
+        switch (config.sendQueuePolicy) {
+
+        case SendQueuePolicy::UNBOUNDED:
+
+            break;
+
+        case SendQueuePolicy::DROP_NEWEST:
 
-            if (this->sendNodes.enqueue(nowNode)) {
+            return SendResult::DROPPED;
 
-                writeChannel.try_send(boost::system::error_code{});
+        case SendQueuePolicy::DROP_OLDEST:
+            // 由写协程在取下一批前按发送顺序淘汰（dropOldest），这里照常入队；
+            // 写协程长时间阻塞在一次写出上时，超过两倍高水位的新消息直接丢弃，队列仍然有界
+            if (queuedNodes.load() + 1 > config.sendQueueHighCount * 2 || queuedBytes.load() + nodeSize > config.sendQueueHighBytes * 2) {
 
-                nowNode = nullptr;
+                return SendResult::DROPPED;
 
             }
 
+            break;
+
+        case SendQueuePolicy::DISCONNECT:
+
+            LOG_WARNING("CSession::writeAsync send queue overflow (%zu bytes), disconnect Session: %s", queuedBytes.load(), getSessionIdString().c_str());
+
+            close();
+
+            return SendResult::CLOSED;
+
+        case SendQueuePolicy::BACKPRESSURE:
+
+            writeBlocked.store(true);
+
+            return SendResult::BACKPRESSURE;
+
         }
     }
-    catch (std::exception& e) {
 
-        LOG_ERROR("CSession::writeAsync (std::string) ERROR: %s", e.what());
+    queuedBytes.fetch_add(nodeSize);
+
+    queuedNodes.fetch_add(1);
+
+    if (this->sendNodes.enqueue(std::move(node))) {
+
+        notifyWriter();
+
+        return SendResult::QUEUED;
 
     }
+
+    queuedBytes.fetch_sub(nodeSize);
+
+    queuedNodes.fetch_sub(1);
+
+    return SendResult::DROPPED;
+}
+
+bool CSession::isControlFrame(const SendNode& node)
+{
+    return node.switchProtocol || node.id == PROTOCOL_NEGOTIATE_ID || node.id == HEARTBEAT_ID || node.id == SERVER_BUSY_ID;
+}
+
+boost::asio::awaitable<void> CSession::waitWritable()
+{
+    const SessionConfig& config = SessionConfig::get();
+
+    for (;;) {
+        // 先置位再检查水位：onBatchWritten 在两者之间写空队列时也能看到标志并发送唤醒
+        writeBlocked.store(true);
+
+        if (isStop.load() || (queuedNodes.load() <= config.sendQueueLowCount && queuedBytes.load() <= config.sendQueueLowBytes)) {
+
+            break;
+
+        }
+
+        co_await writableChannel.async_receive(boost::asio::use_awaitable);
+
+    }
+
+    writeBlocked.store(false);
+    // 唤醒可能同时等待的其他调用者
+    writableChannel.try_send(boost::system::error_code{});
 }
 
 void CSession::writerCoroutineAsync()
@@ -259,42 +570,75 @@ void CSession::writerCoroutineAsync()
 
     auto self = shared_from_this();
 
-    boost::asio::co_spawn(context, [self]() -> boost::asio::awaitable<void> {
+    boost::asio::co_spawn(getIoContext(), [self]() -> boost::asio::awaitable<void> {
+
+        // 迁移后会换用新的通道，协程只使用启动时的通道
+        WriteChannel* channel = self->writeChannel.load();
+
+        self->writerRunning = true;
+
+        struct WriterGuard {
+            CSession* session;
+            ~WriterGuard() {
+                session->writerParked = false;
+                session->writerRunning = false;
+                session->wakeMigration();
+            }
+        } writerGuard{ self.get() };
+
+        // 超出上一批预算、留到下一批发送的节点
+        std::shared_ptr<SendNode> carryNode = nullptr;
+
+        std::vector<std::shared_ptr<SendNode>> batchNodes;
+
+        std::vector<boost::asio::const_buffer> batchBuffers;
+
+        batchNodes.reserve(MAX_WRITE_BATCH_BUFFERS);
+
+        batchBuffers.reserve(MAX_WRITE_BATCH_BUFFERS);
+
+        // 每个节点一个消息头重编码槽位，需在 async_write 完成前保持有效
+        self->headerScratch.resize(MAX_WRITE_BATCH_BUFFERS * MAX_HEAD_TOTAL_LEN);
         
         for (;;) {
 
-            std::shared_ptr<SendNode> nowNode = nullptr;
+            bool stopping = self->isStop.load();
 
-            while (self->sendNodes.try_dequeue(nowNode)) {
+            size_t batchBytes = 0;
+            // 一次取出队列中尽可能多的节点，合并为一次 scatter-gather 写
+            while (self->collectWriteBatch(carryNode, batchNodes, batchBuffers, batchBytes)) {
 
-                if (nowNode != nullptr) {
+                co_await boost::asio::async_write(self->socket, batchBuffers, boost::asio::use_awaitable);
 
-                    co_await boost::asio::async_write(self->socket, boost::asio::buffer(nowNode->data, nowNode->bufferSize), boost::asio::use_awaitable);
+                size_t written = boost::asio::buffer_size(batchBuffers);
 
-                }
+                NetworkMetrics::getInstance()->recordWriteBatch(batchNodes.size(), written);
 
-                nowNode = nullptr;
+                if (ContextLoad* contextLoad = self->load.load()) contextLoad->bytes.fetch_add(written, std::memory_order_relaxed);
 
-            }
-            
-            if(!self->isStop.load()) {
+                self->onBatchWritten(batchNodes.size(), batchBytes);
+
+                batchNodes.clear();
 
-                co_await self->writeChannel.async_receive(boost::asio::use_awaitable);
+                batchBuffers.clear();
 
             }
-            else {
-                std::shared_ptr<SendNode> nowNode = nullptr;
+            
+            if (!stopping) {
 
-                while (self->sendNodes.try_dequeue(nowNode)) {
+                // 迁移时仍有线程在用的旧通道，在此确认无人使用后释放
+                if (!self->retiredChannels.empty() && self->channelUsers.load() == 0) self->retiredChannels.clear();
 
-                    if (nowNode != nullptr) {
+                self->writerParked = true;
 
-                        co_await boost::asio::async_write(self->socket, boost::asio::buffer(nowNode->data, nowNode->bufferSize), boost::asio::use_awaitable);
+                co_await channel->async_receive(boost::asio::use_awaitable);
 
-                    }
+                self->writerParked = false;
+                // 迁移时直接退出，队列中的节点由 target 上的新写协程发送
+                if (self->migrating) co_return;
 
-                    nowNode = nullptr;
-                }
+            }
+            else {
 
                 co_return; // 退出协程
             }
@@ -316,13 +660,13 @@ void CSession::writerCoroutineAsync()
                     if (e.code() == boost::asio::error::eof ||
                         e.code() == boost::asio::error::connection_reset) {
 
-                        LOG_INFO("Client disconnected: %s, Session: %s", e.what(), sessionID.c_str());
+                        LOG_INFO("Client disconnected: %s, Session: %s", e.what(), getSessionIdString().c_str());
 
                     }
                     else {
 
                         LOG_ERROR("CSession coroutine error: %s (Code: %d), Session: %s",
-                            e.what(), e.code().value(), sessionID.c_str());
+                            e.what(), e.code().value(), getSessionIdString().c_str());
 
                     }
 
@@ -334,7 +678,7 @@ void CSession::writerCoroutineAsync()
                 }
                 catch (const std::exception& e) {
 
-                    LOG_ERROR("CSession coroutine std::exception: %s, Session: %s", e.what(), sessionID.c_str());
+                    LOG_ERROR("CSession coroutine std::exception: %s, Session: %s", e.what(), getSessionIdString().c_str());
 
                     if (this && !this->isStop.load()) {
                         this->handleError(
@@ -346,7 +690,7 @@ void CSession::writerCoroutineAsync()
                 }
                 catch (...) {
 
-                    LOG_ERROR("CSession coroutine unknown exception, Session: %s", sessionID.c_str());
+                    LOG_ERROR("CSession coroutine unknown exception, Session: %s", getSessionIdString().c_str());
 
                     if (this && !this->isStop.load()) {
 
@@ -362,6 +706,286 @@ void CSession::writerCoroutineAsync()
 }
 
 
+bool CSession::collectWriteBatch(std::shared_ptr<SendNode>& carryNode, std::vector<std::shared_ptr<SendNode>>& batchNodes,
+    std::vector<boost::asio::const_buffer>& batchBuffers, size_t& batchBytes)
+{
+    batchBytes = 0;
+    // 按发送端当前协议版本追加节点；协商应答写出后，其后的节点改用新版本编码
+    auto appendNode = [this, &batchNodes, &batchBuffers, &batchBytes](std::shared_ptr<SendNode> node) {
+
+        batchBytes += node->totalSize();
+
+        node->appendBuffers(batchBuffers, sendVersion, headerScratch.data() + batchNodes.size() * MAX_HEAD_TOTAL_LEN);
+
+        if (node->switchProtocol) {
+
+            sendVersion = node->switchVersion;
+
+        }
+
+        batchNodes.push_back(std::move(node));
+
+    };
+
+    if (carryNode != nullptr) {
+
+        appendNode(std::move(carryNode));
+
+        carryNode = nullptr;
+
+    }
+
+    const SessionConfig& config = SessionConfig::get();
+
+    if (config.sendQueuePolicy == SendQueuePolicy::DROP_OLDEST) {
+
+        dropOldest(config);
+
+    }
+    // 先发送已取到 pendingNodes 的节点，它们早于 sendNodes 中剩余的节点
+    auto nextNode = [this](std::shared_ptr<SendNode>& node) {
+
+        if (pendingNodes.empty()) return sendNodes.try_dequeue(node);
+
+        node = std::move(pendingNodes.front());
+
+        pendingNodes.pop_front();
+
+        return true;
+
+    };
+
+    std::shared_ptr<SendNode> nowNode = nullptr;
+
+    while (batchBuffers.size() + 2 <= MAX_WRITE_BATCH_BUFFERS && batchBytes < MAX_WRITE_BATCH_BYTES
+        && nextNode(nowNode)) {
+
+        if (nowNode == nullptr) continue;
+
+        if (!batchNodes.empty() && batchBytes + nowNode->totalSize() > MAX_WRITE_BATCH_BYTES) {
+            // 超出字节预算，留到下一批
+            carryNode = std::move(nowNode);
+
+            break;
+
+        }
+
+        appendNode(std::move(nowNode));
+
+        nowNode = nullptr;
+
+    }
+
+    return !batchNodes.empty();
+}
+
+void CSession::dropOldest(const SessionConfig& config)
+{
+    if (queuedNodes.load() <= config.sendQueueHighCount && queuedBytes.load() <= config.sendQueueHighBytes) return;
+    // 取出全部已入队的节点，之后按写协程的发送顺序从最旧的开始丢弃
+    std::shared_ptr<SendNode> node = nullptr;
+
+    while (sendNodes.try_dequeue(node)) {
+
+        if (node != nullptr) pendingNodes.push_back(std::move(node));
+
+        node = nullptr;
+
+    }
+    // 控制帧不丢弃，按原顺序放回队首
+    std::vector<std::shared_ptr<SendNode>> controlNodes;
+
+    while (!pendingNodes.empty() && (queuedNodes.load() > config.sendQueueLowCount || queuedBytes.load() > config.sendQueueLowBytes)) {
+
+        node = std::move(pendingNodes.front());
+
+        pendingNodes.pop_front();
+
+        if (isControlFrame(*node)) {
+
+            controlNodes.push_back(std::move(node));
+
+            continue;
+
+        }
+
+        queuedBytes.fetch_sub(node->totalSize());
+
+        queuedNodes.fetch_sub(1);
+
+    }
+
+    pendingNodes.insert(pendingNodes.begin(), std::make_move_iterator(controlNodes.begin()), std::make_move_iterator(controlNodes.end()));
+}
+
+void CSession::onBatchWritten(size_t nodes, size_t bytes)
+{
+    queuedBytes.fetch_sub(bytes);
+
+    queuedNodes.fetch_sub(nodes);
+
+    const SessionConfig& config = SessionConfig::get();
+    // 回落到低水位以下时唤醒等待 waitWritable() 的调用者
+    if (writeBlocked.load() && queuedNodes.load() <= config.sendQueueLowCount && queuedBytes.load() <= config.sendQueueLowBytes) {
+
+        writeBlocked.store(false);
+
+        writableChannel.try_send(boost::system::error_code{});
+
+    }
+}
+
+bool CSession::shouldPauseReading()
+{
+    const SessionConfig& config = SessionConfig::get();
+
+    return LogicSystem::getInstance()->getPendingMessages() > config.recvQueueHigh
+        || pendingMessages.load() > config.sessionRecvQueueHigh;
+}
+
+boost::asio::awaitable<void> CSession::waitReadable()
+{
+    const SessionConfig& config = SessionConfig::get();
+
+    NetworkMetrics::getInstance()->recordReadPause();
+
+    // 暂停期间读协程不会被迁移，定时器与 wakeReader() 投递的取消都在同一个 context 上
+    boost::asio::steady_timer timer(getIoContext(), boost::asio::steady_timer::time_point::max());
+
+    readableTimer = &timer;
+
+    for (;;) {
+        // 先置位、登记，再检查水位：唤醒方在检查之后才递减的计数必然能看到标志
+        readPaused.store(true);
+
+        bool backlog = LogicSystem::getInstance()->getPendingMessages() > config.recvQueueLow;
+
+        if (backlog && !backlogRegistered.exchange(true)) {
+
+            LogicSystem::getInstance()->addBacklogWaiter(shared_from_this());
+
+        }
+
+        if (isStop.load() || readStopped.load() || (LogicSystem::getInstance()->getPendingMessages() <= config.recvQueueLow
+            && pendingMessages.load() <= config.sessionRecvQueueLow)) {
+
+            break;
+
+        }
+
+        boost::system::error_code ec;
+
+        co_await timer.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+
+    }
+
+    readPaused.store(false);
+
+    readableTimer = nullptr;
+}
+
+void CSession::wakeReader()
+{
+    if (!readPaused.exchange(false)) return;
+
+    auto self = weak_from_this().lock();
+
+    if (!self) return;
+
+    boost::asio::post(getIoContext(), [self]() {
+
+        if (self->readableTimer) self->readableTimer->cancel();
+
+        });
+}
+
+void CSession::onMessageProcessed()
+{
+    size_t remaining = pendingMessages.fetch_sub(1) - 1;
+
+    if (readPaused.load() && remaining <= SessionConfig::get().sessionRecvQueueLow) {
+
+        wakeReader();
+
+    }
+}
+
+void CSession::armDeadline(TimerNode& node, uint64_t timeoutMs)
+{
+    if (timeoutMs == 0) {
+
+        TimingWheel::cancel(node);
+
+        return;
+
+    }
+
+    timingWheel->arm(node, std::chrono::milliseconds(timeoutMs));
+}
+
+void CSession::updateFrameDeadline()
+{
+    if (recvEnd == recvStart) {
+
+        TimingWheel::cancel(frameTimer);
+
+        return;
+
+    }
+
+    FrameHeader header;
+
+    SessionDeadline deadline = FrameCodec::decodeHeader(recvVersion, recvBuffer.get() + recvStart, recvEnd - recvStart, header) == DecodeResult::OK
+        ? SessionDeadline::BODY : SessionDeadline::HEADER;
+
+    if (frameTimer.isArmed() && frameDeadline == deadline) return;
+
+    frameDeadline = deadline;
+
+    const SessionConfig& config = SessionConfig::get();
+
+    armDeadline(frameTimer, deadline == SessionDeadline::HEADER ? config.headerTimeoutMs : config.bodyTimeoutMs);
+}
+
+void CSession::cancelDeadlines()
+{
+    TimingWheel::cancel(frameTimer);
+
+    TimingWheel::cancel(idleTimer);
+
+    TimingWheel::cancel(heartbeatTimer);
+}
+
+void CSession::onDeadline(SessionDeadline deadline)
+{
+    static const char* names[] = { "header", "body", "idle", "heartbeat" };
+
+    LOG_WARNING("CSession %s timeout, close Session: %s", names[static_cast<int>(deadline)], getSessionIdString().c_str());
+
+    close();
+}
+
+void CSession::negotiateProtocol(const char* body, size_t bodySize)
+{
+    ProtocolVersion requested = bodySize > 0 ? static_cast<ProtocolVersion>(static_cast<uint8_t>(body[0])) : ProtocolVersion::LEGACY;
+
+    ProtocolVersion accepted = (requested == ProtocolVersion::V2 && SessionConfig::get().enableProtocolV2)
+        ? ProtocolVersion::V2 : ProtocolVersion::LEGACY;
+    // 应答仍以 LEGACY 编码，写出应答后发送端切换到协商后的版本
+    std::shared_ptr<SendNode> reply = std::make_shared<SendNode>(
+        std::make_shared<const std::string>(1, static_cast<char>(accepted)), static_cast<short>(PROTOCOL_NEGOTIATE_ID));
+
+    reply->switchProtocol = true;
+
+    reply->switchVersion = accepted;
+
+    writeAsync(reply);
+
+    recvVersion = accepted;
+
+    LOG_INFO("CSession protocol negotiated: v%u, Session: %s", static_cast<unsigned>(accepted), getSessionIdString().c_str());
+}
+
 void CSession::handleError(const boost::system::error_code& error, const std::string& context) {
 
 	LOG_ERROR("CSession::handleError - %s: %s", context, error.message());
@@ -377,13 +1001,216 @@ boost::asio::ip::tcp::socket& CSession::getSocket() {
 }
 
 
-std::string CSession::getSessionId() {
+boost::asio::io_context& CSession::getIoContext() {
+
+	return *context.load();
+
+}
+
+
+CServer* CSession::getServer() {
+
+	return server;
+
+}
+
+
+uint64_t CSession::getSessionId() const {
 
 	return sessionID;
 
 }
 
 
+std::string CSession::getSessionIdString() const {
+
+	char buffer[17];
+
+	snprintf(buffer, sizeof(buffer), "%016" PRIx64, sessionID);
+
+	return std::string(buffer);
+
+}
+
+
+void CSession::stopReading() {
+
+    if (readStopped.exchange(true)) {
+
+        return;
+
+    }
+
+    auto self = shared_from_this();
+
+    boost::asio::post(getIoContext(), [self]() {
+
+        self->readCancel.emit(boost::asio::cancellation_type::terminal);
+
+        });
+
+    wakeReader();
+}
+
+boost::asio::awaitable<bool> CSession::migrate(boost::asio::io_context& target)
+{
+    boost::asio::io_context& source = getIoContext();
+    // 读协程挂起在 async_read_some 时缓冲区中只有不完整的帧，写协程挂起时发送队列已写空，迁移不会打断一条消息
+    if (&target == &source || !source.get_executor().running_in_this_thread() || isStop.load() || readStopped.load() || migrating || !readerParked || !writerParked) {
+
+        co_return false;
+
+    }
+
+    migrating = true;
+
+    readCancel.emit(boost::asio::cancellation_type::terminal);
+
+    notifyWriter();
+
+    // 读写协程退出时取消该定时器唤醒这里，不轮询
+    boost::asio::steady_timer exited(source, boost::asio::steady_timer::time_point::max());
+
+    migrationWaiter = &exited;
+
+    // 协程帧在 io_context 析构时也可能直接销毁，先于定时器置空指针
+    struct WaiterGuard {
+        CSession* session;
+        ~WaiterGuard() {
+            session->migrationWaiter = nullptr;
+        }
+    } waiterGuard{ this };
+
+    while (readerRunning || writerRunning) {
+
+        boost::system::error_code ec;
+
+        co_await exited.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+
+    }
+
+    bool migrated = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutexs);
+
+        if (!isStop.load()) {
+
+            boost::system::error_code ec;
+
+            boost::asio::ip::tcp::endpoint endpoint = socket.local_endpoint(ec);
+
+            boost::asio::ip::tcp::socket::native_handle_type handle = ec ? boost::asio::ip::tcp::socket::native_handle_type() : socket.release(ec);
+
+            if (!ec) {
+
+                socket = boost::asio::ip::tcp::socket(target, endpoint.protocol(), handle);
+
+                // 写协程已退出，旧通道上没有挂起的接收；其他线程可能刚取到旧指针，先退休，确认无人使用后再释放
+                retiredChannels.push_back(std::move(currentChannel));
+
+                currentChannel = std::make_unique<WriteChannel>(target, 1);
+
+                writeChannel.store(currentChannel.get());
+
+                if (channelUsers.load() == 0) retiredChannels.clear();
+
+                context.store(&target);
+
+                timingWheel = &TimingWheel::of(target);
+
+                ContextLoad* targetLoad = AsioProactors::getInstance()->getLoad(target);
+
+                // close() 会把 load 置空并扣减；只有仍持有来源统计时才转移，避免与 close() 重复扣减
+                ContextLoad* sourceLoad = load.load();
+
+                if (sourceLoad && load.compare_exchange_strong(sourceLoad, targetLoad)) {
+
+                    sourceLoad->sessions.fetch_sub(1, std::memory_order_relaxed);
+
+                    if (targetLoad) targetLoad->sessions.fetch_add(1, std::memory_order_relaxed);
+
+                }
+
+                migrated = true;
+
+            }
+            else {
+
+                LOG_ERROR("CSession::migrate failed to release socket: %s, Session: %s", ec.message().c_str(), getSessionIdString().c_str());
+
+            }
+        }
+    }
+
+    migrating = false;
+
+    if (!migrated) {
+
+        // 释放句柄失败时连接本身仍然正常，在原 io_context 上恢复读写
+        if (!isStop.load()) {
+
+            writerCoroutineAsync();
+
+            readerCoroutineAsync();
+
+        }
+
+        co_return false;
+
+    }
+
+    writerCoroutineAsync();
+
+    readerCoroutineAsync();
+
+    co_return true;
+}
+
+void CSession::wakeMigration()
+{
+    if (migrationWaiter != nullptr) {
+
+        migrationWaiter->cancel();
+
+    }
+}
+
+void CSession::notifyWriter()
+{
+    // 先登记再取指针，migrate() 在替换指针后看到计数为 0 即可确认没有线程持有旧指针
+    channelUsers.fetch_add(1);
+
+    writeChannel.load()->try_send(boost::system::error_code{});
+
+    channelUsers.fetch_sub(1);
+}
+
+void CSession::closeSocket() {
+    // 与 migrate() 替换 socket 互斥
+    std::lock_guard<std::mutex> lock(mutexs);
+
+    // UNSAFE_IO 模式下 socket 没有描述符锁，关闭必须在所属线程执行；析构时已无并发 I/O，直接关闭
+    if (AsioProactors::getInstance()->getConcurrencyMode() == ConcurrencyMode::UNSAFE_IO && !getIoContext().get_executor().running_in_this_thread()) {
+
+        if (auto self = weak_from_this().lock()) {
+
+            AsioProactors::getInstance()->handoff(getIoContext(), [self]() {
+
+                self->closeSocket();
+
+                });
+
+            return;
+
+        }
+    }
+
+    boost::system::error_code ec;
+
+    socket.close(ec);
+}
+
 void CSession::close() {
 
     bool expected = false;
@@ -394,9 +1221,14 @@ void CSession::close() {
     
     }
 
-    boost::system::error_code ec;
+    // 与 migrate() 转移统计互斥：置空后迁移不再转移，只扣减一次
+    if (ContextLoad* contextLoad = load.exchange(nullptr)) contextLoad->sessions.fetch_sub(1, std::memory_order_relaxed);
 
-    socket.close(ec);
+    closeSocket();
+
+    writableChannel.try_send(boost::system::error_code{});
+
+    wakeReader();
 
     if (server) {
 
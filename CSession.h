@@ -4,9 +4,76 @@
 #include <boost/asio.hpp>
 #include <boost/asio/experimental/concurrent_channel.hpp>
 #include "concurrentqueue.h"
+#include "TimingWheel.h"
+#include <deque>
 
 class CServer;
 
+// ͶгˮλʱĴ
+enum class SendQueuePolicy {
+	UNBOUNDED,     // ƣˮλǰΪһ
+	DROP_NEWEST,   // Ϣ
+	DROP_OLDEST,   // ɵϢ
+	DISCONNECT,    // Ͽٿͻ
+	BACKPRESSURE   // ܾӣɵߵȴ waitWritable() 
+};
+
+// Ựʱ
+enum class SessionDeadline {
+	HEADER,
+	BODY,
+	IDLE,
+	HEARTBEAT
+};
+
+// writeAsync ķؽ
+enum class SendResult {
+	QUEUED,
+	DROPPED,
+	BACKPRESSURE,
+	CLOSED
+};
+
+// Ựã config.ini [Session] ȡһ
+struct SessionConfig {
+	uint64_t maxBodyLength = MAX_BODY_LENGTH;
+
+	size_t sendQueueHighBytes = SEND_QUEUE_HIGH_BYTES;
+
+	size_t sendQueueLowBytes = SEND_QUEUE_HIGH_BYTES / 2;
+
+	size_t sendQueueHighCount = MAX_SENDQUE;
+
+	size_t sendQueueLowCount = MAX_SENDQUE / 2;
+
+	SendQueuePolicy sendQueuePolicy = SendQueuePolicy::UNBOUNDED;
+
+	// ǷͻЭ V2 Э
+	bool enableProtocolV2 = true;
+
+	// LogicSystem ȫִϢĶͣ/ָˮλ
+	size_t recvQueueHigh = MAX_RECVQUE;
+
+	size_t recvQueueLow = MAX_RECVQUE / 2;
+
+	// ỰϢĶͣ/ָˮλ
+	size_t sessionRecvQueueHigh = MAX_SESSION_RECVQUE;
+
+	size_t sessionRecvQueueLow = MAX_SESSION_RECVQUE / 2;
+
+	// ʱ룬0 ʾƣϢͷϢ塢ҵϢκ
+	uint64_t headerTimeoutMs = 5000;
+
+	uint64_t bodyTimeoutMs = 30000;
+
+	// ʱĬϹرգδ֡ľɿͻ˲˱Ͽ
+	uint64_t idleTimeoutMs = 0;
+
+	uint64_t heartbeatTimeoutMs = 0;
+
+	static const SessionConfig& get();
+};
+
 class CSession : public std::enable_shared_from_this<CSession> {
 	friend class LogicSystem;
 	friend class CServer;
@@ -17,39 +84,199 @@ public:
 
 	boost::asio::ip::tcp::socket& getSocket();
 
-	std::string getSessionId();
+	uint64_t getSessionId() const;
+
+	// ־ҪʱʽΪ 16 λʮַ
+	std::string getSessionIdString() const;
+
+	boost::asio::io_context& getIoContext();
+
+	CServer* getServer();
+
+	SendResult writeAsync(char* msg, int64_t max_length, short msgid);
 
-	void writeAsync(char* msg, int64_t max_length, short msgid);
+	SendResult writeAsync(std::string msg, short msgid);
 
-	void writeAsync(std::string msg, short msgid);
+	// 㿽ͣϢԹֻʽ뷢Ͷ
+	SendResult writeAsync(std::shared_ptr<const std::string> payload, short msgid);
+
+	SendResult writeAsync(std::shared_ptr<SendNode> node);
+
+	// ȴͶл䵽ˮλ£Ựرգ SendResult::BACKPRESSURE ʹ
+	boost::asio::awaitable<void> waitWritable();
+
+	size_t getQueuedBytes() const { return queuedBytes.load(); }
 
 	void start();
 
+	// ֹͣϢŹرգͶмдɴ̵߳
+	void stopReading();
+
+	// ѻỰǨƵ targetͷԭ socket  target °װдЭ target 
+	// ڻỰǰ io_context ִУֻждЭ̶ڿеȴʱŻǨƣ򷵻 false
+	boost::asio::awaitable<bool> migrate(boost::asio::io_context& target);
+
 	void close();
 
 private:
 
+	static uint64_t nextSessionId();
+
+	void closeSocket();
+
 	void writerCoroutineAsync(); //ʹboost::asio::awaitableboost::asio::co_spawnЭ ģʽ
 
+	void readerCoroutineAsync();
+
 	void handleError(const boost::system::error_code& error, const std::string& context);
 
+	//  sendNodes ȡһͽڵ㣨ֽ뻺ԤƣǷȡڵ
+	bool collectWriteBatch(std::shared_ptr<SendNode>& carryNode, std::vector<std::shared_ptr<SendNode>>& batchNodes,
+		std::vector<boost::asio::const_buffer>& batchBuffers, size_t& batchBytes);
+
+	// DROP_OLDESTˮλʱ sendNodes ȡ pendingNodesɵĽڵ㿪ʼˮλֻдЭ̵
+	void dropOldest(const SessionConfig& config);
+
+	// һд·Ͷˮλ
+	void onBatchWritten(size_t nodes, size_t bytes);
+
+	// ЭЭ֡ظܵİ汾лնЭ
+	void negotiateProtocol(const char* body, size_t bodySize);
+
+	// Ϣˮλʱ true
+	bool shouldPauseReading();
+
+	// ͣȡֱϢ䵽ˮλ£ڼں˽մڻԷͷ
+	// ѯȫˮλ LogicSystem ڻ䵽ˮλʱѣỰˮλɴ걾ỰϢʱ
+	boost::asio::awaitable<void> waitReadable();
+
+	// Эͣʱ¼ˮλɴ̵߳
+	void wakeReader();
+
+	// LogicSystem 걾ỰһϢ
+	void onMessageProcessed();
+
+	// ڻỰ io_context ʱóʱtimeoutMs Ϊ 0 ʱȡ
+	void armDeadline(TimerNode& node, uint64_t timeoutMs);
+
+	// дڲ֡ʱϢͷ/Ϣ峬ʱûʱȡ
+	void updateFrameDeadline();
+
+	void cancelDeadlines();
+
+	void onDeadline(SessionDeadline deadline);
+
 private:
 
 	boost::asio::ip::tcp::socket socket;
 
-	boost::asio::io_context& context;
+	//  io_contextǨʱ滻
+	std::atomic<boost::asio::io_context*> context;
+
+	//  io_context ʱ֣ÿóʱ use_service ң context һǨʱ滻
+	TimingWheel* timingWheel;
 
-	std::string sessionID;
+	uint64_t sessionID;
 
 	CServer* server;
 
+	//  io_context ĸͳƣ AsioProactors ӷ
+	std::atomic<ContextLoad*> load;
+
 	std::atomic<bool> isStop;
 
+	std::atomic<bool> readStopped{ false };
+
+	// Э waitReadable() еȴ
+	std::atomic<bool> readPaused{ false };
+
+	// ѵǼǵ LogicSystem ȫˮλȴбʱ
+	std::atomic<bool> backlogRegistered{ false };
+
+	// waitReadable() ڼĵȴʱֻ context ߳Ϸ
+	boost::asio::steady_timer* readableTimer = nullptr;
+
+	// ȡĶֻ context ߳ϴ
+	boost::asio::cancellation_signal readCancel;
+
+	// ջδݵ [recvStart, recvEnd)
+	std::unique_ptr<char[]> recvBuffer;
+
+	size_t recvStart = 0;
+
+	size_t recvEnd = 0;
+
+	// ն뷢Ͷ˵ǰʹõЭ汾ֱֻɶЭ̺дЭ̷
+	ProtocolVersion recvVersion = ProtocolVersion::LEGACY;
+
+	ProtocolVersion sendVersion = ProtocolVersion::LEGACY;
+
+	std::vector<char> headerScratch;
+
+	// ʱʱֻɶЭ context ߳úȡ
+	TimerNode frameTimer;
+
+	SessionDeadline frameDeadline = SessionDeadline::HEADER;
+
+	TimerNode idleTimer;
+
+	TimerNode heartbeatTimer;
+
 	moodycamel::ConcurrentQueue<std::shared_ptr<SendNode>> sendNodes{ 1 };
 
+	// дЭ̶ռĴͽڵ㣬 sendNodes ӵ˳У sendNodes ʣĽڵ
+	// sendNodes ֻ֤ͬһDROP_OLDEST ﰴдЭʵʵķ˳̭֡ԭλ
+	std::deque<std::shared_ptr<SendNode>> pendingNodes;
+
+	// ЭӦæ֪ͨȿܷ֡ͶвӰ
+	static bool isControlFrame(const SendNode& node);
+
+	// ӵδдֽڵ
+	std::atomic<size_t> queuedBytes{ 0 };
+
+	std::atomic<size_t> queuedNodes{ 0 };
+
+	std::atomic<bool> writeBlocked{ false };
+
+	// ỰͶݵ LogicSystem δɵϢ
+	std::atomic<size_t> pendingMessages{ 0 };
+
 	std::mutex mutexs;
 
-	boost::asio::experimental::concurrent_channel<void(boost::system::error_code)> writeChannel;
+	using WriteChannel = boost::asio::experimental::concurrent_channel<void(boost::system::error_code)>;
+
+	// дЭ̵Ļͨ io_context 󶨣Ľջռø io_context  workǨʱ滻
+	std::atomic<WriteChannel*> writeChannel;
+
+	std::unique_ptr<WriteChannel> currentChannel;
+
+	// ͨ writeChannel дЭ̵߳Ϊ 0 ʱ滻ͨͷ
+	std::atomic<size_t> channelUsers{ 0 };
+
+	// Ǩ滻߳ʹõֻͨ io_context ߳Ϸ
+	std::vector<std::unique_ptr<WriteChannel>> retiredChannels;
+
+	// дЭ̣ɴ̵߳
+	void notifyWriter();
+
+	// Ǩ״ֻ̬ io_context ߳Ϸ
+	bool migrating = false;
+
+	bool readerRunning = false;
+
+	bool writerRunning = false;
+
+	// migrate() ȴдЭ˳ʱĶʱЭ˳ʱȡԻ
+	boost::asio::steady_timer* migrationWaiter = nullptr;
+
+	void wakeMigration();
+
+	// Э̹ async_read_someдЭ̹ڵȴ
+	bool readerParked = false;
+
+	bool writerParked = false;
+
+	boost::asio::experimental::concurrent_channel<void(boost::system::error_code)> writableChannel;
 
 
 };
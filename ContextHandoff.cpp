@@ -0,0 +1,21 @@
+#include "ContextHandoff.h"
+
+void ContextHandoff::push(std::function<void()> task) {
+    tasks.enqueue(std::move(task));
+
+    if (!scheduled.exchange(true)) {
+        boost::asio::post(context, [this]() { drain(); });
+    }
+}
+
+void ContextHandoff::drain() {
+    // 先清除标志再取任务：之后入队的生产者会重新投递，任务不会滞留
+    scheduled.store(false);
+
+    std::function<void()> task;
+
+    while (tasks.try_dequeue(task)) {
+        task();
+        task = nullptr;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <atomic>
+#include <functional>
+#include "concurrentqueue.h"
+
+// 向某个 io_context 线程移交任务的无锁队列
+// 生产者只做一次无锁入队；队列从空变为非空时才向 io_context 投递一次排空回调，多次移交合并为一次调度
+// 用于 UNSAFE_IO 模式：socket 的注册、关闭等 reactor 操作必须在所属线程上执行
+class ContextHandoff {
+public:
+    explicit ContextHandoff(boost::asio::io_context& context) : context(context) {}
+
+    ContextHandoff(const ContextHandoff& handoff) = delete;
+
+    ContextHandoff& operator=(const ContextHandoff& handoff) = delete;
+
+    // 可从任意线程调用
+    void push(std::function<void()> task);
+
+private:
+    void drain();
+
+    boost::asio::io_context& context;
+
+    moodycamel::ConcurrentQueue<std::function<void()>> tasks;
+
+    std::atomic<bool> scheduled{ false };
+};
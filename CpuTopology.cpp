@@ -0,0 +1,212 @@
+#include "CpuTopology.h"
+#include "ConfigMgr.h"
+#include "Utils.h"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <tuple>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+    int readIntFile(const std::string& path, int defaultValue) {
+        std::ifstream file(path);
+        int value = defaultValue;
+        if (!(file >> value)) return defaultValue;
+        return value;
+    }
+
+    std::string readTextFile(const std::string& path) {
+        std::ifstream file(path);
+        std::string text;
+        std::getline(file, text);
+        return text;
+    }
+
+    PinningPolicy parsePolicy(const std::string& text) {
+        if (text == "compact") return PinningPolicy::COMPACT;
+        if (text == "scatter") return PinningPolicy::SCATTER;
+        if (text == "numa") return PinningPolicy::NUMA;
+        return PinningPolicy::NONE;
+    }
+
+}
+
+CpuTopology::CpuTopology() {
+    discover();
+}
+
+std::vector<int> CpuTopology::parseCpuList(const std::string& text) {
+    // 形如 "0-3,8-11,16"
+    std::vector<int> result;
+    std::stringstream stream(text);
+    std::string range;
+
+    while (std::getline(stream, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++) result.push_back(cpu);
+        }
+        catch (const std::exception&) {
+            return {};
+        }
+    }
+
+    return result;
+}
+
+void CpuTopology::discover() {
+    const std::string cpuRoot = "/sys/devices/system/cpu/";
+    std::vector<int> online = parseCpuList(readTextFile(cpuRoot + "online"));
+
+    if (online.empty()) {
+        // 没有 sysfs（非 Linux 或容器中被屏蔽）时视为单节点、每个 CPU 一个核心
+        unsigned count = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < count; i++) online.push_back(static_cast<int>(i));
+    }
+
+    std::map<int, int> cpuNode;
+    const std::string nodeRoot = "/sys/devices/system/node/";
+
+    for (int node : parseCpuList(readTextFile(nodeRoot + "online"))) {
+        std::string list = readTextFile(nodeRoot + "node" + std::to_string(node) + "/cpulist");
+        for (int cpu : parseCpuList(list)) cpuNode[cpu] = node;
+    }
+
+    std::map<int, int> nodeIndex;
+
+    for (int cpu : online) {
+        CpuInfo info;
+        info.cpu = cpu;
+        std::string topology = cpuRoot + "cpu" + std::to_string(cpu) + "/topology/";
+        info.core = readIntFile(topology + "core_id", cpu);
+        info.package = readIntFile(topology + "physical_package_id", 0);
+        auto iter = cpuNode.find(cpu);
+        int node = iter == cpuNode.end() ? 0 : iter->second;
+        // 节点编号可能不连续，压缩为 0..nodeCount-1
+        auto inserted = nodeIndex.emplace(node, static_cast<int>(nodeIndex.size()));
+        info.node = inserted.first->second;
+        cpus.push_back(info);
+    }
+
+    nodeCount = std::max<size_t>(1, nodeIndex.size());
+    nodeCpus.assign(nodeCount, {});
+
+    for (const CpuInfo& info : cpus) nodeCpus[info.node].push_back(info.cpu);
+
+    std::vector<CpuInfo> sorted = cpus;
+
+    // compact：同一插槽、同一物理核的超线程相邻
+    std::sort(sorted.begin(), sorted.end(), [](const CpuInfo& a, const CpuInfo& b) {
+        return std::tie(a.node, a.package, a.core, a.cpu) < std::tie(b.node, b.package, b.core, b.cpu);
+    });
+    for (const CpuInfo& info : sorted) compactOrder.push_back(info.cpu);
+
+    // scatter：先按超线程序号分层，每层内按物理核序号在各节点间交错
+    std::map<std::tuple<int, int, int>, int> siblingRank;
+    std::map<int, std::map<std::pair<int, int>, int>> coreRank;
+    std::vector<std::tuple<int, int, int, int>> keys;
+
+    for (const CpuInfo& info : sorted) {
+        int smt = siblingRank[{ info.node, info.package, info.core }]++;
+        auto& ranks = coreRank[info.node];
+        auto core = ranks.emplace(std::make_pair(info.package, info.core), static_cast<int>(ranks.size())).first->second;
+        keys.emplace_back(smt, core, info.node, info.cpu);
+    }
+
+    std::sort(keys.begin(), keys.end());
+    for (const auto& key : keys) scatterOrder.push_back(std::get<3>(key));
+
+    LOG_INFO("CpuTopology: %zu CPUs, %zu NUMA nodes", cpus.size(), nodeCount);
+}
+
+PinningPolicy CpuTopology::getPolicy(const std::string& pool) const {
+    SectionInfo section = ConfigMgr::Inst()["CpuAffinity"];
+    std::string policy = section[pool];
+    return parsePolicy(policy.empty() ? section["Policy"] : policy);
+}
+
+void CpuTopology::reserve(const std::string& pool, size_t count) {
+    std::lock_guard<std::mutex> lock(mutexs);
+
+    Slice& slice = slices[pool];
+
+    // config.ini [CpuAffinity] <pool>Cpus = 0-3,8-11：显式指定时不占用自动划分的区间
+    slice.explicitCpus = parseCpuList(ConfigMgr::Inst()["CpuAffinity"][pool + "Cpus"]);
+    if (!slice.explicitCpus.empty()) return;
+
+    slice.offset = reserved;
+    slice.count = std::max<size_t>(1, count);
+    reserved += slice.count;
+
+    if (getPolicy(pool) != PinningPolicy::NONE && reserved > cpus.size()) {
+        LOG_WARNING("CpuTopology: %zu CPUs reserved across pools but only %zu online, %s overlaps earlier pools; set [CpuAffinity] %sCpus to separate them",
+            reserved, cpus.size(), pool.c_str(), pool.c_str());
+    }
+}
+
+std::vector<int> CpuTopology::cpusFor(const std::string& pool, size_t index) const {
+    PinningPolicy policy = getPolicy(pool);
+    if (policy == PinningPolicy::NONE) return {};
+
+    Slice slice;
+    {
+        std::lock_guard<std::mutex> lock(mutexs);
+        auto iter = slices.find(pool);
+        if (iter != slices.end()) slice = iter->second;
+    }
+
+    if (!slice.explicitCpus.empty()) {
+        if (policy == PinningPolicy::NUMA) return slice.explicitCpus;
+        return { slice.explicitCpus[index % slice.explicitCpus.size()] };
+    }
+
+    // 未登记的线程池从 0 开始，每个线程各占一个位置
+    size_t position = slice.offset + (slice.count == 0 ? index : index % slice.count);
+
+    switch (policy) {
+    case PinningPolicy::COMPACT:
+        return { compactOrder[position % compactOrder.size()] };
+    case PinningPolicy::SCATTER:
+        return { scatterOrder[position % scatterOrder.size()] };
+    case PinningPolicy::NUMA:
+        // 按节点划分时同样错开起点，使各线程池优先落在不同节点
+        return nodeCpus[position % nodeCount];
+    default:
+        return {};
+    }
+}
+
+void CpuTopology::pinCurrentThread(const std::string& pool, size_t index) const {
+    std::vector<int> targets = cpusFor(pool, index);
+    if (targets.empty()) return;
+
+    bool pinned = false;
+
+#ifdef _WIN32
+    DWORD_PTR mask = 0;
+    for (int cpu : targets) {
+        if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) mask |= static_cast<DWORD_PTR>(1) << cpu;
+    }
+    pinned = mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : targets) CPU_SET(cpu, &set);
+    pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+
+    if (!pinned) {
+        LOG_WARNING("CpuTopology: failed to pin %s thread %zu", pool.c_str(), index);
+    }
+}
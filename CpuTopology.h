@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 逻辑 CPU 的拓扑位置
+struct CpuInfo {
+    int cpu = 0;
+    int core = 0;
+    int package = 0;
+    int node = 0;
+};
+
+// 线程绑定策略
+enum class PinningPolicy {
+    NONE,      // 不绑定
+    COMPACT,   // 依次填满同一物理核的超线程、同一插槽的核心
+    SCATTER,   // 先分散到不同 NUMA 节点和物理核，最后才使用超线程
+    NUMA       // 每个线程绑定到一个 NUMA 节点的全部 CPU，线程按节点轮流分配
+};
+
+// 从 /sys/devices/system/cpu 与 /sys/devices/system/node 读取 CPU 拓扑，并按 config.ini [CpuAffinity] 绑定线程
+// 线程池名称即配置键名（AsioProactors、LogicSystem、SessionSendThread），未单独配置时使用 Policy
+// 各线程池占用互不重叠的 CPU 区间：<pool>Cpus 显式指定，否则按登记顺序在策略顺序中依次划分
+class CpuTopology {
+public:
+    static CpuTopology* getInstance() {
+        static CpuTopology instance;
+        return &instance;
+    }
+
+    CpuTopology(const CpuTopology& topology) = delete;
+
+    CpuTopology& operator=(const CpuTopology& topology) = delete;
+
+    const std::vector<CpuInfo>& getCpus() const { return cpus; }
+
+    size_t getNodeCount() const { return nodeCount; }
+
+    PinningPolicy getPolicy(const std::string& pool) const;
+
+    // 线程池启动线程前登记，为其划出 count 个 CPU（通常为线程预算批准的启动线程数），接在之前登记的线程池之后
+    void reserve(const std::string& pool, size_t count);
+
+    // 线程池中第 index 个线程应绑定的 CPU 集合，NONE 时为空；超出区间的线程在本线程池的区间内轮转
+    std::vector<int> cpusFor(const std::string& pool, size_t index) const;
+
+    // 在线程函数开头调用，把当前线程绑定到 cpusFor(pool, index)
+    void pinCurrentThread(const std::string& pool, size_t index) const;
+
+private:
+    CpuTopology();
+
+    void discover();
+
+    static std::vector<int> parseCpuList(const std::string& text);
+
+    std::vector<CpuInfo> cpus;
+
+    // 按策略预先排好的 CPU 顺序
+    std::vector<int> compactOrder;
+
+    std::vector<int> scatterOrder;
+
+    std::vector<std::vector<int>> nodeCpus;
+
+    size_t nodeCount = 1;
+
+    // 各线程池在策略顺序中的起点与长度，显式配置的 CPU 列表单独保存
+    struct Slice {
+        size_t offset = 0;
+        size_t count = 0;
+        std::vector<int> explicitCpus;
+    };
+
+    std::map<std::string, Slice> slices;
+
+    // 已划分出的 CPU 数，即下一个线程池的起点
+    size_t reserved = 0;
+
+    mutable std::mutex mutexs;
+};
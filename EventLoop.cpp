@@ -0,0 +1,192 @@
+#include "EventLoop.h"
+#include "ConfigMgr.h"
+#include "Utils.h"
+
+std::chrono::microseconds EventLoop::spinBudget(const std::string& pool) {
+    std::string value = ConfigMgr::Inst()[pool]["SpinMicros"];
+    return std::chrono::microseconds(value.empty() ? 0 : std::stoll(value));
+}
+
+void EventLoop::run(boost::asio::io_context& context, std::chrono::microseconds spin, LoopStats& stats) {
+    if (spin.count() <= 0) {
+        // 与 run() 等价：有就绪处理器时逐个 poll_one() 执行，队列为空才阻塞
+        // 时钟读取比一次 poll_one() 更贵，只对每 16 个处理器中的一个计时，处理时间按计时样本平均
+        uint64_t sequence = 0;
+        for (;;) {
+            bool timed = (sequence++ & 15) == 0;
+            auto start = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+            if (context.poll_one() != 0) {
+                if (timed) {
+                    auto end = std::chrono::steady_clock::now();
+                    stats.busyNanos.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()), std::memory_order_relaxed);
+                    stats.timedHandlers.fetch_add(1, std::memory_order_relaxed);
+                }
+                stats.handlers.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (context.stopped()) {
+                break;
+            }
+            stats.blocks.fetch_add(1, std::memory_order_relaxed);
+            if (context.run_one() == 0) {
+                break;
+            }
+            stats.handlers.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    auto idleSince = std::chrono::steady_clock::now();
+
+    while (!context.stopped()) {
+        auto start = std::chrono::steady_clock::now();
+        size_t executed = context.poll();
+        auto end = std::chrono::steady_clock::now();
+        uint64_t elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+
+        if (executed > 0) {
+            stats.busyNanos.fetch_add(elapsed, std::memory_order_relaxed);
+            stats.handlers.fetch_add(executed, std::memory_order_relaxed);
+            stats.timedHandlers.fetch_add(executed, std::memory_order_relaxed);
+            idleSince = end;
+            continue;
+        }
+
+        stats.spinNanos.fetch_add(elapsed, std::memory_order_relaxed);
+
+        if (end - idleSince < spin) {
+            continue;
+        }
+
+        // 自旋预算耗尽，阻塞等待下一个处理器；没有剩余工作或已停止时返回 0
+        stats.blocks.fetch_add(1, std::memory_order_relaxed);
+        if (context.run_one() == 0) {
+            break;
+        }
+        stats.handlers.fetch_add(1, std::memory_order_relaxed);
+        idleSince = std::chrono::steady_clock::now();
+    }
+}
+
+LoopTotals EventLoop::totals(const LoopStats* stats, size_t count) {
+    LoopTotals totals;
+
+    for (size_t i = 0; i < count; i++) {
+        totals.spinNanos += stats[i].spinNanos.load(std::memory_order_relaxed);
+        totals.busyNanos += stats[i].busyNanos.load(std::memory_order_relaxed);
+        totals.handlers += stats[i].handlers.load(std::memory_order_relaxed);
+        totals.timedHandlers += stats[i].timedHandlers.load(std::memory_order_relaxed);
+        totals.blocks += stats[i].blocks.load(std::memory_order_relaxed);
+    }
+
+    return totals;
+}
+
+void EventLoop::logStats(const char* pool, std::chrono::microseconds spin, const LoopTotals& current, const LoopTotals& previous) {
+    if (spin.count() <= 0) {
+        return;
+    }
+
+    uint64_t spinNanos = current.spinNanos - previous.spinNanos;
+    uint64_t busyNanos = current.busyNanos - previous.busyNanos;
+    uint64_t total = spinNanos + busyNanos;
+
+    // 阻塞时间不计入：比例反映的是线程占用 CPU 的时间里有多少花在空转上
+    LOG_INFO("%s: Spin %lldus, Spin/Busy: %0.1f%%/%0.1f%%, Blocks: %llu", pool,
+        static_cast<long long>(spin.count()),
+        total == 0 ? 0.0 : 100.0 * spinNanos / total,
+        total == 0 ? 0.0 : 100.0 * busyNanos / total,
+        static_cast<unsigned long long>(current.blocks - previous.blocks));
+}
+
+boost::asio::awaitable<uint64_t> EventLoop::probeLag(boost::asio::io_context& context, LoopStats& stats) {
+    auto posted = std::chrono::steady_clock::now();
+
+    // 投递到队尾，恢复时间即排在它前面的处理器全部执行完的时间
+    co_await boost::asio::post(context, boost::asio::use_awaitable);
+
+    uint64_t lag = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - posted).count());
+
+    stats.lagHistogram.record(lag);
+    stats.lagMicros.store((stats.lagMicros.load(std::memory_order_relaxed) * 7 + lag) / 8, std::memory_order_relaxed);
+
+    co_return lag;
+}
+
+void EventLoop::sampleHandlerRate(LoopStats& stats, std::chrono::steady_clock::duration elapsed) {
+    uint64_t handlers = stats.handlers.load(std::memory_order_relaxed);
+    uint64_t micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    uint64_t rate = micros == 0 ? 0 : (handlers - stats.probedHandlers) * 1000000 / micros;
+
+    stats.probedHandlers = handlers;
+    stats.handlersPerSecond.store(rate, std::memory_order_relaxed);
+    stats.handlerRateHistogram.record(rate);
+}
+
+void EventLoop::startProbe(boost::asio::io_context& context, LoopStats& stats, const std::atomic<bool>& stop) {
+    boost::asio::co_spawn(context, [&context, &stats, &stop]() -> boost::asio::awaitable<void> {
+        boost::asio::steady_timer timer(context);
+        const std::chrono::milliseconds interval(100);
+        auto lastSample = std::chrono::steady_clock::now();
+        stats.probedHandlers = stats.handlers.load(std::memory_order_relaxed);
+
+        while (!stop.load()) {
+            timer.expires_after(interval);
+            co_await timer.async_wait(boost::asio::use_awaitable);
+
+            co_await probeLag(context, stats);
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastSample >= std::chrono::seconds(1)) {
+                sampleHandlerRate(stats, now - lastSample);
+                lastSample = now;
+            }
+        }
+        }, boost::asio::detached);
+}
+
+LoopSnapshot EventLoop::snapshot(LoopStats* stats, size_t count) {
+    LoopSnapshot snapshot;
+    Histogram lag;
+    Histogram rate;
+
+    for (size_t i = 0; i < count; i++) {
+        if (stats[i].lagHistogram.getCount() == 0) continue;
+
+        uint64_t p99 = stats[i].lagHistogram.percentile(0.99);
+        if (p99 >= snapshot.worstLagP99) {
+            snapshot.worstLagP99 = p99;
+            snapshot.worstIndex = i;
+        }
+        snapshot.totalRate += stats[i].handlersPerSecond.load(std::memory_order_relaxed);
+
+        lag.merge(stats[i].lagHistogram);
+        rate.merge(stats[i].handlerRateHistogram);
+        stats[i].lagHistogram.reset();
+        stats[i].handlerRateHistogram.reset();
+    }
+
+    snapshot.samples = lag.getCount();
+    snapshot.lagP50 = lag.percentile(0.5);
+    snapshot.lagP99 = lag.percentile(0.99);
+    snapshot.rateP50 = rate.percentile(0.5);
+    snapshot.rateP99 = rate.percentile(0.99);
+
+    return snapshot;
+}
+
+void EventLoop::logLatency(const char* pool, const LoopSnapshot& snapshot) {
+    if (snapshot.samples == 0) {
+        return;
+    }
+
+    LOG_INFO("%s: Loop Lag p50/p99: %llu/%lluus, Worst Context: %zu (p99 %lluus)", pool,
+        static_cast<unsigned long long>(snapshot.lagP50),
+        static_cast<unsigned long long>(snapshot.lagP99),
+        snapshot.worstIndex, static_cast<unsigned long long>(snapshot.worstLagP99));
+
+    LOG_INFO("%s: Handlers/s per Context p50/p99: %llu/%llu, Total: %llu", pool,
+        static_cast<unsigned long long>(snapshot.rateP50),
+        static_cast<unsigned long long>(snapshot.rateP99),
+        static_cast<unsigned long long>(snapshot.totalRate));
+}
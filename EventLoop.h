@@ -0,0 +1,79 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "Histogram.h"
+
+// 事件循环的运行统计，由运行该 io_context 的线程与其上的探测协程写入；计数只增不减，直方图由监控线程读取后清零
+struct alignas(64) LoopStats {
+    // poll() 没有取到就绪处理器的自旋时间（纳秒）
+    std::atomic<uint64_t> spinNanos{ 0 };
+    // poll()/poll_one() 执行处理器的时间（纳秒）
+    std::atomic<uint64_t> busyNanos{ 0 };
+    std::atomic<uint64_t> handlers{ 0 };
+    // 执行时间计入 busyNanos 的处理器数；阻塞唤醒后由 run_one() 执行的处理器无法与等待时间分开，不计入
+    std::atomic<uint64_t> timedHandlers{ 0 };
+    // 自旋超时后阻塞在 run_one() 的次数
+    std::atomic<uint64_t> blocks{ 0 };
+    // 调度延迟（微秒，指数加权平均）：探测处理器从投递到开始执行的时间
+    std::atomic<uint64_t> lagMicros{ 0 };
+    std::atomic<uint64_t> handlersPerSecond{ 0 };
+    Histogram lagHistogram;
+    Histogram handlerRateHistogram;
+    // 上次计算速率时的处理器计数，仅探测协程访问
+    uint64_t probedHandlers = 0;
+};
+
+// 一组 LoopStats 计数的合计，前后两次相减得到区间内的增量
+struct LoopTotals {
+    uint64_t spinNanos = 0;
+    uint64_t busyNanos = 0;
+    uint64_t handlers = 0;
+    uint64_t timedHandlers = 0;
+    uint64_t blocks = 0;
+};
+
+// 一组 context 的调度延迟与处理器速率分布
+struct LoopSnapshot {
+    uint64_t lagP50 = 0;
+    uint64_t lagP99 = 0;
+    size_t worstIndex = 0;
+    uint64_t worstLagP99 = 0;
+    uint64_t rateP50 = 0;
+    uint64_t rateP99 = 0;
+    uint64_t totalRate = 0;
+    uint64_t samples = 0;
+};
+
+// io_context 的运行方式：自旋预算为 0 时逐个 poll_one() 执行就绪处理器并计时，没有就绪处理器时阻塞在 run_one()；
+// 否则先用 poll() 忙等，连续 spin 时间内没有就绪处理器才阻塞在 run_one()，以 CPU 换取更低的唤醒延迟
+// 与 socket 的 SO_BUSY_POLL（[SocketProfile.<name>] BusyPoll）配合使用
+class EventLoop {
+public:
+    // config.ini [<pool>] SpinMicros，缺省为 0
+    static std::chrono::microseconds spinBudget(const std::string& pool);
+
+    static void run(boost::asio::io_context& context, std::chrono::microseconds spin, LoopStats& stats);
+
+    // 在 context 上投递一个带时间戳的探测处理器并等待其执行，记录调度延迟，返回延迟微秒数
+    // 须在运行于 context 上的协程中调用
+    static boost::asio::awaitable<uint64_t> probeLag(boost::asio::io_context& context, LoopStats& stats);
+
+    // 按上次采样以来的处理器增量记录每秒处理器数
+    static void sampleHandlerRate(LoopStats& stats, std::chrono::steady_clock::duration elapsed);
+
+    // 启动通用探测协程：每 100ms 测量一次调度延迟，每秒记录处理器速率，stop 置位后退出
+    static void startProbe(boost::asio::io_context& context, LoopStats& stats, const std::atomic<bool>& stop);
+
+    static LoopTotals totals(const LoopStats* stats, size_t count);
+
+    // 汇总并清零一组 context 的调度延迟与处理器速率直方图，记录延迟最高的 context
+    static LoopSnapshot snapshot(LoopStats* stats, size_t count);
+
+    // 输出两次合计之间自旋与执行处理器各占的时间比例；spin 为 0 时不输出
+    static void logStats(const char* pool, std::chrono::microseconds spin, const LoopTotals& current, const LoopTotals& previous);
+
+    static void logLatency(const char* pool, const LoopSnapshot& snapshot);
+};
@@ -0,0 +1,154 @@
+#include "FrameCodec.h"
+#include "const.h"
+
+size_t FrameCodec::encodeHeader(ProtocolVersion version, char* header, short id, int64_t length,
+    uint8_t flags, uint64_t requestId) {
+    if (version == ProtocolVersion::V2) {
+        return encodeV2Header(header, id, length, flags, requestId);
+    }
+    return encodeLegacyHeader(header, id, length);
+}
+
+DecodeResult FrameCodec::decodeHeader(ProtocolVersion version, const char* data, size_t size, FrameHeader& header) {
+    if (version == ProtocolVersion::V2) {
+        return decodeV2Header(data, size, header);
+    }
+    return decodeLegacyHeader(data, size, header);
+}
+
+size_t FrameCodec::encodeLegacyHeader(char* header, short id, int64_t length) {
+    uint16_t msgId = static_cast<uint16_t>(id);
+    uint32_t bodyLength = static_cast<uint32_t>(length);
+
+    header[0] = static_cast<char>(msgId >> 8);
+    header[1] = static_cast<char>(msgId);
+    header[2] = static_cast<char>(bodyLength >> 24);
+    header[3] = static_cast<char>(bodyLength >> 16);
+    header[4] = static_cast<char>(bodyLength >> 8);
+    header[5] = static_cast<char>(bodyLength);
+    header[6] = 0;
+    header[7] = 0;
+    header[8] = 0;
+    header[9] = 0;
+
+    return HEAD_TOTAL_LEN;
+}
+
+DecodeResult FrameCodec::decodeLegacyHeader(const char* data, size_t size, FrameHeader& header) {
+    if (size < HEAD_TOTAL_LEN) {
+        return DecodeResult::NEED_MORE;
+    }
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+    uint32_t high = (uint32_t(bytes[2]) << 24) | (uint32_t(bytes[3]) << 16) | (uint32_t(bytes[4]) << 8) | bytes[5];
+    uint32_t low = (uint32_t(bytes[6]) << 24) | (uint32_t(bytes[7]) << 16) | (uint32_t(bytes[8]) << 8) | bytes[9];
+
+    header.id = static_cast<short>((uint16_t(bytes[0]) << 8) | bytes[1]);
+    header.flags = 0;
+    header.requestId = 0;
+    header.headerLength = HEAD_TOTAL_LEN;
+
+    if (low == 0) {
+        // 小端主机写出的形式：[32 位大端长度][0]
+        header.length = high;
+    }
+    else if (high == 0) {
+        // 64 位大端长度（大端主机写出，且长度小于 4GB）
+        header.length = low;
+    }
+    else {
+        return DecodeResult::INVALID;
+    }
+
+    return DecodeResult::OK;
+}
+
+size_t FrameCodec::encodeV2Header(char* header, short id, int64_t length, uint8_t flags, uint64_t requestId) {
+    uint16_t msgId = static_cast<uint16_t>(id);
+
+    if (requestId != 0) {
+        flags |= FRAME_FLAG_REQUEST_ID;
+    }
+
+    header[0] = static_cast<char>(flags);
+    header[1] = static_cast<char>(msgId >> 8);
+    header[2] = static_cast<char>(msgId);
+
+    size_t offset = 3;
+    offset += encodeVarint(header + offset, static_cast<uint64_t>(length));
+
+    if (flags & FRAME_FLAG_REQUEST_ID) {
+        offset += encodeVarint(header + offset, requestId);
+    }
+
+    return offset;
+}
+
+DecodeResult FrameCodec::decodeV2Header(const char* data, size_t size, FrameHeader& header) {
+    if (size < 4) {
+        return DecodeResult::NEED_MORE;
+    }
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+    header.flags = bytes[0];
+    header.id = static_cast<short>((uint16_t(bytes[1]) << 8) | bytes[2]);
+
+    size_t offset = 3;
+    size_t consumed = 0;
+    uint64_t length = 0;
+
+    DecodeResult result = decodeVarint(data + offset, size - offset, length, consumed);
+    if (result != DecodeResult::OK) {
+        return result;
+    }
+    if (length > static_cast<uint64_t>(INT64_MAX)) {
+        return DecodeResult::INVALID;
+    }
+    offset += consumed;
+
+    header.length = static_cast<int64_t>(length);
+    header.requestId = 0;
+
+    if (header.flags & FRAME_FLAG_REQUEST_ID) {
+        result = decodeVarint(data + offset, size - offset, header.requestId, consumed);
+        if (result != DecodeResult::OK) {
+            return result;
+        }
+        offset += consumed;
+    }
+
+    header.headerLength = offset;
+    return DecodeResult::OK;
+}
+
+size_t FrameCodec::encodeVarint(char* out, uint64_t value) {
+    size_t offset = 0;
+    while (value >= 0x80) {
+        out[offset++] = static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out[offset++] = static_cast<char>(value);
+    return offset;
+}
+
+DecodeResult FrameCodec::decodeVarint(const char* data, size_t size, uint64_t& value, size_t& consumed) {
+    value = 0;
+    for (size_t i = 0; i < 10; i++) {
+        if (i >= size) {
+            return DecodeResult::NEED_MORE;
+        }
+        uint8_t byte = static_cast<uint8_t>(data[i]);
+        if (i == 9 && byte > 1) {
+            // 第 10 个字节只能携带最高 1 位
+            return DecodeResult::INVALID;
+        }
+        value |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            consumed = i + 1;
+            return DecodeResult::OK;
+        }
+    }
+    return DecodeResult::INVALID;
+}
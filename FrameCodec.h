@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// 线路协议版本：LEGACY 为固定 10 字节消息头，V2 为变长紧凑消息头，通过协商切换
+enum class ProtocolVersion : uint8_t {
+    LEGACY = 1,
+    V2 = 2
+};
+
+// V2 消息头标志位
+constexpr uint8_t FRAME_FLAG_COMPRESSED = 0x01;
+constexpr uint8_t FRAME_FLAG_FRAGMENTED = 0x02;
+constexpr uint8_t FRAME_FLAG_PRIORITY = 0x04;
+constexpr uint8_t FRAME_FLAG_REQUEST_ID = 0x08;
+
+// V2 消息头最大长度：flags(1) + id(2) + 长度 varint(10) + 请求 ID varint(10)
+constexpr size_t MAX_HEAD_TOTAL_LEN = 24;
+
+struct FrameHeader {
+    short id = 0;
+    int64_t length = 0;
+    uint8_t flags = 0;
+    uint64_t requestId = 0;
+    size_t headerLength = 0;
+};
+
+enum class DecodeResult {
+    OK,
+    NEED_MORE,
+    INVALID
+};
+
+// 消息头编解码，与主机字节序无关
+//
+// LEGACY: [id: 2 字节大端][长度: 8 字节]
+//   长度字段历史上由 32 位 host_to_network_long 写出，小端主机上为 [32 位大端长度][4 字节 0]，
+//   大端主机上为 64 位大端长度；解码时两种形式都接受，编码时输出前者以兼容已部署的客户端
+//
+// V2:     [flags: 1 字节][id: 2 字节大端][长度: varint][请求 ID: varint，仅 FRAME_FLAG_REQUEST_ID]
+class FrameCodec {
+public:
+    static size_t encodeHeader(ProtocolVersion version, char* header, short id, int64_t length,
+        uint8_t flags = 0, uint64_t requestId = 0);
+
+    static DecodeResult decodeHeader(ProtocolVersion version, const char* data, size_t size, FrameHeader& header);
+
+    static size_t encodeLegacyHeader(char* header, short id, int64_t length);
+
+    static DecodeResult decodeLegacyHeader(const char* data, size_t size, FrameHeader& header);
+
+    static size_t encodeV2Header(char* header, short id, int64_t length, uint8_t flags, uint64_t requestId);
+
+    static DecodeResult decodeV2Header(const char* data, size_t size, FrameHeader& header);
+
+private:
+    static size_t encodeVarint(char* out, uint64_t value);
+
+    static DecodeResult decodeVarint(const char* data, size_t size, uint64_t& value, size_t& consumed);
+};
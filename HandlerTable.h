@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 以 uint16_t 消息 ID 直接索引的处理器表，长度为最大已注册 ID + 1（每项 8 字节，覆盖全部 65536 个 ID 需 512KB），
+// 未注册的表项为 nullptr；查找只需一次边界检查和一次下标访问
+// 处理器是编译期生成的无状态跳板函数，Owner 实例作为第一个参数传入，不经过 std::function/std::bind
+// 注册在启动时完成，之后只读，多线程查找无需同步
+template<typename Owner, typename Session>
+class HandlerTable {
+public:
+    using Handler = void (*)(Owner& owner, const std::shared_ptr<Session>& session,
+        const short& msg_id, const std::string& msg_data);
+
+    // 把成员函数登记到消息 ID 对应的表项
+    template<void (Owner::* Method)(std::shared_ptr<Session>, const short&, const std::string&)>
+    void add(short msgId) {
+        uint16_t index = static_cast<uint16_t>(msgId);
+        if (index >= handlers.size()) {
+            handlers.resize(static_cast<size_t>(index) + 1, nullptr);
+        }
+        handlers[index] = [](Owner& owner, const std::shared_ptr<Session>& session,
+            const short& msg_id, const std::string& msg_data) {
+                (owner.*Method)(session, msg_id, msg_data);
+            };
+    }
+
+    // 未注册时返回 nullptr
+    Handler find(short msgId) const {
+        uint16_t index = static_cast<uint16_t>(msgId);
+        return index < handlers.size() ? handlers[index] : nullptr;
+    }
+
+    size_t bytes() const { return handlers.size() * sizeof(Handler); }
+
+private:
+    std::vector<Handler> handlers;
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// 以 2 的幂为桶边界的无锁直方图：桶 i 统计 [2^(i-1), 2^i) 范围内的取值，桶 0 统计 0
+class Histogram {
+public:
+    static constexpr size_t BUCKET_COUNT = 32;
+
+    void record(uint64_t value) {
+        size_t index = 0;
+        while (value != 0 && index < BUCKET_COUNT - 1) {
+            value >>= 1;
+            index++;
+        }
+        buckets[index].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t getCount() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    // 近似分位数：返回包含该分位的桶上界
+    uint64_t percentile(double ratio) const {
+        uint64_t total = getCount();
+        if (total == 0) return 0;
+        uint64_t target = static_cast<uint64_t>(total * ratio);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen > target) {
+                return i == 0 ? 0 : (uint64_t(1) << i) - 1;
+            }
+        }
+        return (uint64_t(1) << (BUCKET_COUNT - 1)) - 1;
+    }
+
+    // 累加另一个直方图的计数，用于汇总多个线程的分布
+    void merge(const Histogram& other) {
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            buckets[i].fetch_add(other.buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        count.fetch_add(other.getCount(), std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (auto& bucket : buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+
+    std::atomic<uint64_t> count{ 0 };
+};
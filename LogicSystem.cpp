@@ -1,260 +1,424 @@
 ﻿#include "LogicSystem.h"
 #include <chrono>
 #include "Utils.h"
+#include "CpuTopology.h"
+#include "ThreadBudget.h"
 
-LogicSystem::LogicSystem(size_t minSize, size_t maxSize) :minSize(minSize), maxSize(maxSize), nowSize(minSize), isStop(false), threads(maxSize), readyQueue(nowSize),ioContexts(nowSize),works(nowSize), channels(nowSize)
+LogicSystem::LogicSystem(size_t minSize, size_t maxSize) :threads(maxSize), isStop(false), minSize(ThreadBudget::getInstance()->registerPool("LogicSystem", minSize, maxSize)), maxSize(maxSize), nowSize(this->minSize), loopStats(maxSize), workerStops(maxSize), autoscaler("LogicSystem", this->minSize, maxSize), works(maxSize), readyQueue(maxSize), channels(maxSize)
  {
+	// 按线程预算批准的启动线程数划出独占的 CPU 区间，接在 AsioProactors 之后
+	CpuTopology::getInstance()->reserve("LogicSystem", this->minSize);
+
+	// 与 I/O 线程使用相同的并发提示，工作协程只与通道交互，不持有 I/O 对象
+	// 按最大线程数预先创建 io_context，扩容时直接启动对应下标
+	for (size_t i = 0; i < maxSize; i++) {
+
+		ioContexts.push_back(std::make_unique<boost::asio::io_context>(AsioProactors::getInstance()->concurrencyHint()));
+
+		channels[i] = std::make_unique<boost::asio::experimental::concurrent_channel<void(boost::system::error_code)>>(*ioContexts[i], 1);
+
+	}
+
+	// config.ini [LogicSystem] SpinMicros：阻塞前以 poll() 自旋的时间
+	spin = EventLoop::spinBudget("LogicSystem");
+
 	registerCallBackFunction();
 
 }
 
 void LogicSystem::initializeThreads() {
 
-    for (int i = 0; i < nowSize; i++) {
+    for (size_t i = 0; i < nowSize; i++) {
 
-        auto work = std::make_unique<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>(
-            boost::asio::make_work_guard(ioContexts[i])
-        );
+        startWorker(i);
 
-        works[i] = std::move(work);
+    }
 
-        threads[i] = std::move(std::thread([this, i]() {
-            ioContexts[i].run();
-            }));
+	metricsThread = std::move(std::thread([this]() {
 
-        channels[i] = std::make_unique<boost::asio::experimental::concurrent_channel<void(boost::system::error_code)>>(ioContexts[i], 1);
+		auto lastTick = std::chrono::steady_clock::now();
 
-    }
+		auto lastLog = lastTick - updateInterval;
 
-    for (int i = 0; i < nowSize; i++) {
+		uint64_t lastDispatched = dispatched.load();
 
-		auto self = shared_from_this();
+		uint64_t lastServiceNanos = serviceNanos.load();
 
-        boost::asio::co_spawn(ioContexts[i], [self,i]() -> boost::asio::awaitable<void> {
+		LoopTotals loggedTotals = EventLoop::totals(loopStats.data(), loopStats.size());
 
-            for (;;) {
+		while (!waitForStop(autoscaler.getPolicy().interval)) {
 
-                std::shared_ptr<MessageNode> nowNode = nullptr;
+			auto now = std::chrono::steady_clock::now();
 
-                while (self->messageNodes.try_dequeue(nowNode)) {
+			double seconds = std::chrono::duration<double>(now - lastTick).count();
 
-                    if (nowNode != nullptr && nowNode->session != nullptr) {
+			uint64_t nowDispatched = dispatched.load();
 
-                        if (self->callBackFunctions.find(nowNode->id) == self->callBackFunctions.end()) {
+			uint64_t nowServiceNanos = serviceNanos.load();
 
-                            LOG_WARNING("The MessageID %u has no corresponding CallBackFunctions", nowNode->id);
+			uint64_t count = nowDispatched - lastDispatched;
 
-                        }
-                        else {
+			LoopSnapshot snapshot = EventLoop::snapshot(loopStats.data(), nowSize.load());
 
-                            self->callBackFunctions[nowNode->id](nowNode->session, nowNode->id, nowNode->data);
+			ScalingSignals signals;
 
-                        }
+			signals.threads = nowSize.load();
 
-                    }
-                }
+			signals.arrivalRate = seconds > 0 ? count / seconds : 0;
 
-                if (!self->isStop) {
+			signals.serviceMicros = count > 0 ? (nowServiceNanos - lastServiceNanos) / 1000.0 / count : 0;
 
-					self->readyQueue.push(i);
+			signals.queueWaitP99 = queueWaitHistogram.percentile(0.99);
 
-                    co_await self->channels[i]->async_receive(boost::asio::use_awaitable);
-                }
-                else {
+			signals.lagP99 = snapshot.lagP99;
 
-                    std::shared_ptr<MessageNode> nowNode = nullptr;
+			signals.budgetSurplus = ThreadBudget::getInstance()->surplus("LogicSystem");
 
-                    while (self->messageNodes.try_dequeue(nowNode)) {
+			queueWaitHistogram.reset();
 
-                        if (nowNode != nullptr && nowNode->session != nullptr) {
+			lastDispatched = nowDispatched;
 
-                            if (self->callBackFunctions.find(nowNode->id) == self->callBackFunctions.end()) {
+			lastServiceNanos = nowServiceNanos;
 
-                                LOG_WARNING("The MessageID %u has no corresponding CallBackFunctions", nowNode->id);
+			lastTick = now;
 
-                            }
-                            else {
+			resize(autoscaler.evaluate(signals));
 
-                                self->callBackFunctions[nowNode->id](nowNode->session, nowNode->id, nowNode->data);
+			if (now - lastLog >= updateInterval) {
 
-                            }
+				LOG_INFO("LogicSystem: Monitoring system Threads: %u", nowSize.load());
 
-                            nowNode = nullptr;
+				LOG_INFO("LogicSystem: Queue Wait p99: %lluus, Service: %0.1fus, Rate: %0.0f/s",
+					static_cast<unsigned long long>(signals.queueWaitP99), signals.serviceMicros, signals.arrivalRate);
 
-                        }
-                    }
-                    co_return;
+				LoopTotals totals = EventLoop::totals(loopStats.data(), loopStats.size());
 
-                }
+				EventLoop::logStats("LogicSystem", spin, totals, loggedTotals);
 
-            }
+				EventLoop::logLatency("LogicSystem", snapshot);
 
-            co_return;
+				loggedTotals = totals;
 
-            }, [this](std::exception_ptr p) {
-                if (p) {
-                    try {
+				lastLog = now;
 
-                        std::rethrow_exception(p);
+			}
 
-                    }
-                    catch (const std::exception& e) {
+		}
 
-                        LOG_ERROR("LogicSystem coroutine std::exception: %s", e.what());
-                    }
-                }
-                });
-    }
+		}));
 
-	metricsThread = std::move(std::thread([this]() {
-		
-		while (!isStop) {
 
-            if (this->messageNodes.size_approx() > 0) pressuresCount++;
+}
 
-            LOG_INFO("LogicSystem: Monitoring system Threads: %u", nowSize.load());
+void LogicSystem::startWorker(size_t index) {
 
-			LOG_INFO("LogicSystem: Message Pressure: %0.2f", pressuresCount.load());
+	workerStops[index].store(false);
 
-			if (pressuresCount > 3) {
+	// 退役时 io_context 因没有剩余工作而结束，需要 restart() 后才能再次运行
+	ioContexts[index]->restart();
 
-				if (this->nowSize == this->maxSize) {
+	works[index] = std::make_unique<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>(
+		boost::asio::make_work_guard(*ioContexts[index])
+	);
 
-					std::this_thread::sleep_for(updateInterval);
+	loopStats[index].lagHistogram.reset();
 
-					continue;
-				}
+	loopStats[index].handlerRateHistogram.reset();
 
-				size_t newIndex = this->nowSize.load();    // 先获取当前大小作为新索引
+	threads[index] = std::move(std::thread([this, index]() {
+		CpuTopology::getInstance()->pinCurrentThread("LogicSystem", index);
+		EventLoop::run(*ioContexts[index], spin, loopStats[index]);
+		}));
+
+	auto self = shared_from_this();
+
+	boost::asio::co_spawn(*ioContexts[index], [self, index]() -> boost::asio::awaitable<void> {
+
+		for (;;) {
 
-				this->nowSize.fetch_add(1);
+			std::shared_ptr<MessageNode> nowNode = nullptr;
 
-				threads[newIndex] = std::move(std::thread([this, newIndex]() {
+			while (self->messageNodes.try_dequeue(nowNode)) {
 
-					processMessageTemporary(shared_from_this());
+				if (nowNode != nullptr && nowNode->session != nullptr) {
+
+					self->dispatchMessage(nowNode);
+
+				}
+			}
 
-					}));
+			if (!self->isStop && !self->workerStops[index]) {
 
-                threads[newIndex].detach();
+				self->readyQueue.push(static_cast<int>(index));
 
-				pressuresCount.store(0); // 重置压力计数器
+				co_await self->channels[index]->async_receive(boost::asio::use_awaitable);
 			}
+			else {
 
-			std::this_thread::sleep_for(updateInterval);
+				std::shared_ptr<MessageNode> nowNode = nullptr;
+
+				while (self->messageNodes.try_dequeue(nowNode)) {
+
+					if (nowNode != nullptr && nowNode->session != nullptr) {
+
+						self->dispatchMessage(nowNode);
+
+						nowNode = nullptr;
+
+					}
+				}
+				co_return;
+
+			}
 
 		}
 
-		}));
+		co_return;
+
+		}, [this](std::exception_ptr p) {
+			if (p) {
+				try {
+
+					std::rethrow_exception(p);
+
+				}
+				catch (const std::exception& e) {
+
+					LOG_ERROR("LogicSystem coroutine std::exception: %s", e.what());
+				}
+			}
+			});
+
+	// 调度延迟包含排在探测之前的消息处理时间，退役或 stop() 后探测协程最多 100ms 内退出
+	EventLoop::startProbe(*ioContexts[index], loopStats[index], workerStops[index]);
+
+}
+
+void LogicSystem::retireWorker(size_t index) {
+
+	workerStops[index].store(true);
+
+	// 通道容量为 1，已有未消费的唤醒时发送失败，但工作协程同样会醒来并看到退出标志
+	channels[index]->try_send(boost::system::error_code{});
+
+	works[index].reset();
+
+	// 工作协程处理完手头的消息、探测协程退出后 io_context 没有剩余工作，线程随之结束
+	if (threads[index].joinable()) {
 
+		threads[index].join();
+
+	}
+
+}
+
+void LogicSystem::resize(size_t target) {
+
+	// 扩容的线程已由 autoscaler 向线程预算申请
+	while (nowSize.load() < target) {
+
+		startWorker(nowSize.load());
+
+		nowSize.fetch_add(1);
+
+	}
+
+	while (nowSize.load() > target) {
+
+		// 先缩小范围，再停止对应的工作线程；readyQueue 中残留的下标由 postMessageToQueue 跳过
+		size_t index = nowSize.fetch_sub(1) - 1;
+
+		retireWorker(index);
+
+		ThreadBudget::getInstance()->release("LogicSystem", 1);
+
+	}
 
 }
 
 LogicSystem::~LogicSystem() {
 
-	isStop = true;
+	stop();
 
-	for (auto& thread : threads) {
+}
 
-		if (thread.joinable()) {
+bool LogicSystem::waitForStop(std::chrono::milliseconds timeout) {
 
-			thread.join();
+	std::unique_lock<std::mutex> lock(stopMutex);
+
+	return stopCondition.wait_for(lock, timeout, [this]() { return isStop.load(); });
+
+}
+
+bool LogicSystem::drain(std::chrono::steady_clock::time_point deadline) {
+
+	while (pendingMessages.load() > 0 && std::chrono::steady_clock::now() < deadline) {
+		// 唤醒所有空闲的工作协程
+		int readyIndex = -1;
+
+		while (readyQueue.pop(readyIndex)) {
+
+			if (readyIndex >= 0) channels[readyIndex]->try_send(boost::system::error_code{});
 
 		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
 	}
 
+	size_t remaining = pendingMessages.load();
+
+	if (remaining > 0) {
+
+		LOG_WARNING("LogicSystem::drain deadline exceeded, %zu messages pending", remaining);
+
+	}
+
+	return remaining == 0;
+
 }
 
+void LogicSystem::stop() {
 
-void LogicSystem::processMessageTemporary(std::shared_ptr<LogicSystem> logicSystem) {
-    // 记录最后活动时间，初始为当前时间
-    auto lastActivityTime = std::chrono::steady_clock::now();
+	{
+		std::lock_guard<std::mutex> lock(stopMutex);
 
-    const auto idleTimeout = std::chrono::seconds(60); // 60秒超时
+		if (isStop.exchange(true)) return;
+	}
 
-    const auto checkInterval = std::chrono::milliseconds(100); // 检查间隔
+	stopCondition.notify_all();
 
-    for (;;) {
-        // 检查停止标志
-        if (isStop) {
+	// 先停止监控线程，之后工作线程集合不再变化
+	if (metricsThread.joinable()) {
 
-            std::shared_ptr<MessageNode> nowNode = nullptr;
-            // 处理完剩余所有消息后退出
-            while (logicSystem->messageNodes.try_dequeue(nowNode)) {
+		metricsThread.join();
 
-                if (nowNode != nullptr && nowNode->session != nullptr) {
+	}
 
-                    if (callBackFunctions.find(nowNode->id) == callBackFunctions.end()) {
+	// 唤醒等待中的工作协程，使其处理完剩余消息后退出；同时通知探测协程退出
+	for (size_t i = 0; i < maxSize; i++) {
 
-                        LOG_WARNING("The MessageID %u has no corresponding CallBackFunctions", nowNode->id);
+		workerStops[i].store(true);
 
-                    }
-                    else {
+		if (channels[i]) channels[i]->try_send(boost::system::error_code{});
 
-                        callBackFunctions[nowNode->id](nowNode->session, nowNode->id, nowNode->data);
+	}
 
+	for (auto& work : works) {
 
-                    }
-                }
+		work.reset();
 
-                nowNode = nullptr;
+	}
 
-                this->nowSize.fetch_sub(1);
+	for (auto& thread : threads) {
 
-                return;
-            }
-            // 尝试从队列中获取消息
-            
-        }
+		if (thread.joinable()) {
+
+			thread.join();
+
+		}
+	}
 
-        std::shared_ptr<MessageNode> nowNode = nullptr;
+}
 
-        while (logicSystem->messageNodes.try_dequeue(nowNode)) {
-            // 成功获取到消息，更新最后活动时间
-            lastActivityTime = std::chrono::steady_clock::now();
+void LogicSystem::dispatchMessage(const std::shared_ptr<MessageNode>& node) {
 
-            if (nowNode != nullptr && nowNode->session != nullptr) {
+    auto start = std::chrono::steady_clock::now();
 
-                if (callBackFunctions.find(nowNode->id) == callBackFunctions.end()) {
+    queueWaitHistogram.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(start - node->enqueueTime).count()));
 
-                    LOG_WARNING("The MessageID %u has no corresponding CallBackFunctions", nowNode->id);
-                }
-                else {
+    auto callBack = callBackFunctions.find(node->id);
 
-                    callBackFunctions[nowNode->id](nowNode->session, nowNode->id, nowNode->data);
+    if (callBack == nullptr) {
 
-                    long long end = std::chrono::floor<std::chrono::milliseconds>(
-                        std::chrono::system_clock::now()
-                    ).time_since_epoch().count();
+        LOG_WARNING("The MessageID %u has no corresponding CallBackFunctions", node->id);
 
-                }
-            }
+    }
+    else {
+        // 处理器抛出的异常在此截住：工作协程继续运行，下面的统计与水位计数照常更新，否则会话读取会一直暂停
+        try {
+            // 消息体不以 '\0' 结尾，必须按长度构造
+            callBack(*this, node->session, node->id, std::string(node->data, static_cast<size_t>(node->length)));
         }
-        
-        auto currentTime = std::chrono::steady_clock::now();
+        catch (const std::exception& e) {
 
-        auto idleDuration = currentTime - lastActivityTime;
+            LOG_ERROR("LogicSystem::dispatchMessage MessageID %u handler threw: %s, Session: %s", node->id, e.what(), node->session->getSessionIdString().c_str());
 
-        if (idleDuration >= idleTimeout) {
-            // 空闲时间超过60秒，退出
-            this->nowSize.fetch_sub(1);
+        }
+        catch (...) {
+
+            LOG_ERROR("LogicSystem::dispatchMessage MessageID %u handler threw an unknown exception, Session: %s", node->id, node->session->getSessionIdString().c_str());
 
-            return;
         }
+    }
+
+    serviceNanos.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()), std::memory_order_relaxed);
+
+    dispatched.fetch_add(1, std::memory_order_relaxed);
+
+    // 计数逐一递减，恰好回落到低水位时唤醒一次等待的会话
+    if (pendingMessages.fetch_sub(1) - 1 == SessionConfig::get().recvQueueLow) {
+
+        wakeBacklogWaiters();
 
     }
+
+    node->session->onMessageProcessed();
+
+}
+
+void LogicSystem::addBacklogWaiter(std::shared_ptr<CSession> session) {
+
+	std::lock_guard<std::mutex> lock(waiterMutex);
+
+	backlogWaiters.push_back(session);
+
+}
+
+void LogicSystem::wakeBacklogWaiters() {
+
+	std::vector<std::weak_ptr<CSession>> waiters;
+
+	{
+		std::lock_guard<std::mutex> lock(waiterMutex);
+
+		waiters.swap(backlogWaiters);
+	}
+
+	for (auto& waiter : waiters) {
+
+		if (auto session = waiter.lock()) {
+
+			session->backlogRegistered.store(false);
+
+			session->wakeReader();
+
+		}
+	}
+
 }
 
 void LogicSystem::postMessageToQueue(std::shared_ptr<MessageNode> node) {
 
+	if (node == nullptr || node->session == nullptr) return;
+
+	pendingMessages.fetch_add(1);
+
+	node->session->pendingMessages.fetch_add(1);
+
+	node->enqueueTime = std::chrono::steady_clock::now();
+
 	messageNodes.enqueue(node);
 
 	int readyIndex = -1;
 
-	if (readyQueue.pop(readyIndex)) {
+	while (readyQueue.pop(readyIndex)) {
+		// 跳过已退役工作线程留下的空闲记录
+		if (readyIndex < 0 || workerStops[readyIndex].load()) continue;
 
-        if (readyIndex == -1) return;
+		channels[readyIndex]->try_send(boost::system::error_code{});
 
-        channels[readyIndex]->try_send(boost::system::error_code{});
+		break;
 
 	}
 
@@ -262,8 +426,7 @@ void LogicSystem::postMessageToQueue(std::shared_ptr<MessageNode> node) {
 
 void LogicSystem::registerCallBackFunction() {
 
-	callBackFunctions[1001] = std::bind(&LogicSystem::boostAsioTcpSocket, this,
-		std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+	callBackFunctions.add<&LogicSystem::boostAsioTcpSocket>(1001);
 
 }
 
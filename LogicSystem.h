@@ -6,6 +6,10 @@
 #include <boost/lockfree/queue.hpp>
 #include "concurrentqueue.h"
 #include "Singleton.h"
+#include "EventLoop.h"
+#include "Autoscaler.h"
+#include "Histogram.h"
+#include "HandlerTable.h"
 
 
 class LogicSystem : public Singleton<LogicSystem>, public std::enable_shared_from_this<LogicSystem>
@@ -25,18 +29,50 @@ public:
 
 	void initializeThreads();
 
+	// 等待已入队的消息处理完成，超过 deadline 返回 false
+	bool drain(std::chrono::steady_clock::time_point deadline);
+
+	// 停止全部工作线程，退出前处理完队列中剩余的消息
+	void stop();
+
+	// 已入队但尚未处理完成的消息数，供读端流控使用
+	size_t getPendingMessages() const { return pendingMessages.load(); }
+
+	// 因全局水位暂停读取的会话登记等待，待处理消息回落到 RecvQueueLow 时统一唤醒
+	void addBacklogWaiter(std::shared_ptr<CSession> session);
+
 private:
 
 	void registerCallBackFunction();
 
 	LogicSystem(size_t minSize = std::thread::hardware_concurrency() * 2, size_t maxSize = std::thread::hardware_concurrency() * 4);
 
-	void processMessageTemporary(std::shared_ptr<LogicSystem> logicSystem);
+	// 监控线程的等待，已停止时返回 true
+	bool waitForStop(std::chrono::milliseconds timeout);
+
+	// 启动 index 对应的工作线程、工作协程与探测协程
+	void startWorker(size_t index);
+
+	// 通知 index 的工作协程退出并等待线程结束
+	void retireWorker(size_t index);
+
+	// 扩缩容到 target 个工作线程，只由监控线程调用
+	void resize(size_t target);
+
+	void dispatchMessage(const std::shared_ptr<MessageNode>& node);
 
 	moodycamel::ConcurrentQueue<std::shared_ptr<MessageNode>> messageNodes;
 
-	std::map<short, std::function<void(std::shared_ptr<CSession>,
-		const short& msg_id, const std::string& msg_data)>> callBackFunctions;
+	std::atomic<size_t> pendingMessages{ 0 };
+
+	void wakeBacklogWaiters();
+
+	std::mutex waiterMutex;
+
+	std::vector<std::weak_ptr<CSession>> backlogWaiters;
+
+	// 消息处理器表，注册在构造时完成，之后只读，工作线程无需同步
+	HandlerTable<LogicSystem, CSession> callBackFunctions;
 
 	std::vector<std::thread> threads;
 
@@ -53,11 +89,32 @@ private:
 
 	std::thread metricsThread;
 
+	// 指标日志的输出间隔；扩缩容按 autoscaler 的评估间隔进行
 	std::chrono::milliseconds updateInterval{ 10000 };
 
-	std::atomic<int> pressuresCount{ 0 };
+	std::mutex stopMutex;
+
+	std::condition_variable stopCondition;
+
+	std::vector<std::unique_ptr<boost::asio::io_context>> ioContexts;
+
+	std::vector<LoopStats> loopStats;
+
+	// 工作线程阻塞前的自旋时间，0 为直接阻塞
+	std::chrono::microseconds spin{ 0 };
+
+	// 置位后对应的工作协程与探测协程退出
+	std::vector<std::atomic<bool>> workerStops;
+
+	// 消息从入队到开始处理的等待时间（微秒）
+	Histogram queueWaitHistogram;
+
+	// 消息处理时间累计（纳秒）与处理条数，监控线程按差值计算平均处理时间与到达率
+	std::atomic<uint64_t> serviceNanos{ 0 };
+
+	std::atomic<uint64_t> dispatched{ 0 };
 
-	std::vector<boost::asio::io_context> ioContexts;
+	Autoscaler autoscaler;
 
 	std::vector<std::unique_ptr<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>> works;
 
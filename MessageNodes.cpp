@@ -2,6 +2,7 @@
 #include "FastMemcpy_Avx.h"
 #include <iostream>
 #include "Utils.h"
+#include "BufferPool.h"
 
 MessageNode::MessageNode(int64_t headLength)
     : headLength(static_cast<short>(headLength)),
@@ -28,11 +29,28 @@ MessageNode::~MessageNode() {
     clear();
 }
 
-void MessageNode::clear() {
+bool MessageNode::allocateData(size_t size) {
+    releaseData();
+
+    data = BufferPool::getInstance()->allocate(size);
+    dataSource = MemorySource::MEMORY_POOL;
+
+    if (!data) {
+        // 超过内存池最大级别，回退到普通 new[]
+        data = new(std::nothrow) char[size];
+        dataSource = MemorySource::NORMAL_NEW;
+    }
+
+    bufferSize = data ? size : 0;
+
+    return data != nullptr;
+}
+
+void MessageNode::releaseData() {
     if (data) {
         // 🔧 修复：根据内存来源使用正确的释放方法
         if (dataSource == MemorySource::MEMORY_POOL) {
-            free(data);
+            BufferPool::getInstance()->deallocate(data, bufferSize);
         }
         else {
             // ✅ 普通 new[] 分配的内存使用 delete[] 释放
@@ -40,6 +58,10 @@ void MessageNode::clear() {
         }
         data = nullptr;
     }
+}
+
+void MessageNode::clear() {
+    releaseData();
 
     // 重置所有状态
     length = 0;
@@ -60,6 +82,15 @@ SendNode::SendNode(const char* msg, int64_t max_length, short msgid)
     }
 }
 
+SendNode::SendNode(std::shared_ptr<const std::string> payload, short msgid, uint8_t flags, uint64_t requestId)
+    : MessageNode(HEAD_TOTAL_LEN), payload(std::move(payload)) {
+    this->id = msgid;
+    this->flags = flags;
+    this->requestId = requestId;
+    this->length = this->payload ? static_cast<int64_t>(this->payload->size()) : 0;
+    this->headLength = static_cast<short>(FrameCodec::encodeLegacyHeader(header, msgid, length));
+}
+
 SendNode::~SendNode() {
     // 基类析构函数会处理清理
 }
@@ -69,77 +100,54 @@ bool SendNode::safeSetSendNode(const char* msg, int64_t max_length, short msgid)
         return false;
     }
 
-    // 清理旧数据
-    if (data) {
-        // 🔧 修复：根据内存来源正确释放旧数据
-        if (dataSource == MemorySource::MEMORY_POOL) {
-            free(data);
-        }
-        else {
-            // ✅ 普通 new[] 分配的内存使用 delete[] 释放
-            delete[] data;
-        }
-        data = nullptr;
-    }
-
-    // 准备数据
-    uint16_t msgids = boost::asio::detail::socket_ops::host_to_network_short(
-        static_cast<uint16_t>(msgid));
-    uint64_t max_lengths = boost::asio::detail::socket_ops::host_to_network_long(
-        static_cast<uint64_t>(max_length));
-
     this->id = msgid;
     this->length = max_length;
     size_t total_size = max_length + HEAD_TOTAL_LEN;
-    bufferSize = total_size;
-
-    data = new(std::nothrow) char[total_size];
-    dataSource = MemorySource::NORMAL_NEW;
-    bufferSize = total_size;
 
-    if (!data) {
+    if (!allocateData(total_size)) {
         return false;
     }
 
     // 🔧 修复：确保使用正确的内存拷贝方法
     try {
-        std::memcpy(data, &msgids, HEAD_ID_LEN);
-        std::memcpy(data + HEAD_ID_LEN, &max_lengths, HEAD_DATA_LEN);
+        FrameCodec::encodeLegacyHeader(data, msgid, max_length);
         std::memcpy(data + HEAD_TOTAL_LEN, msg, max_length);
     }
     catch (const std::exception& e) {
 		LOG_ERROR("Memory copy failed in safeSetSendNode: %s" , e.what());
 
         // 清理已分配的内存
-        if (dataSource == MemorySource::MEMORY_POOL) {
-            free(data);
-        }
-        else {
-            delete[] data;
-        }
-        data = nullptr;
+        releaseData();
         return false;
     }
 
     return true;
 }
 
+void SendNode::appendBuffers(std::vector<boost::asio::const_buffer>& buffers, ProtocolVersion version, char* scratch) const {
+    if (version != headerVersion) {
+        const char* body = payload ? payload->data() : data + headLength;
+        size_t bodySize = payload ? payload->size() : (data ? bufferSize - headLength : 0);
+        size_t headerSize = FrameCodec::encodeHeader(version, scratch, id, static_cast<int64_t>(bodySize), flags, requestId);
+        buffers.emplace_back(scratch, headerSize);
+        buffers.emplace_back(body, bodySize);
+    }
+    else if (payload) {
+        buffers.emplace_back(header, headLength);
+        buffers.emplace_back(payload->data(), payload->size());
+    }
+    else {
+        buffers.emplace_back(data, bufferSize);
+    }
+}
+
 void SendNode::setSendNode(const char* msg, int64_t max_length, short msgid) {
     safeSetSendNode(msg, max_length, msgid);
 }
 
 void SendNode::clear() {
-    if (data) {
-        // 🔧 修复：根据内存来源正确释放
-        if (dataSource == MemorySource::MEMORY_POOL) {
-            free(data);
-        }
-        else {
-            // ✅ 普通 new[] 分配的内存使用 delete[] 释放
-            delete[] data;
-        }
-        data = nullptr;
-    }
+    releaseData();
+    payload = nullptr;
 
     // 重置所有状态
     length = 0;
@@ -1,8 +1,12 @@
 #pragma once
 #include "const.h"
+#include "FrameCodec.h"
 #include <mutex>
 #include <atomic>
 #include <cassert>
+#include <vector>
+#include <string>
+#include <chrono>
 
 extern class CSession;
 
@@ -19,6 +23,12 @@ public:
 
     virtual void clear();
 
+    // 按尺寸从内存池（或 new[]）分配数据区，并记录内存来源
+    bool allocateData(size_t size);
+
+    // 根据内存来源释放数据区
+    void releaseData();
+
     // 数据成员
     short headLength;
     short id;
@@ -27,6 +37,13 @@ public:
     size_t bufferSize;
     std::shared_ptr<CSession> session;
 
+    // V2 协议的标志位与请求 ID（LEGACY 协议下恒为 0）
+    uint8_t flags = 0;
+    uint64_t requestId = 0;
+
+    // 进入逻辑队列的时间，用于统计排队等待
+    std::chrono::steady_clock::time_point enqueueTime;
+
     // 🔧 新增：内存来源标记
     MemorySource dataSource = MemorySource::NORMAL_NEW;
 };
@@ -34,11 +51,30 @@ public:
 class SendNode : public MessageNode {
 public:
     SendNode(const char* msg, int64_t max_len, short msg_id);
+    // 零拷贝：消息头内联在节点中，消息体为共享的只读缓冲区，发送时作为两段 scatter-gather 写出
+    SendNode(std::shared_ptr<const std::string> payload, short msg_id, uint8_t flags = 0, uint64_t requestId = 0);
     ~SendNode();
 
+    // 追加本节点对应的发送缓冲区（拷贝节点 1 段，零拷贝节点 2 段）；
+    // 会话协议版本与节点内消息头版本不同时，在 scratch 中按会话版本重新编码消息头
+    void appendBuffers(std::vector<boost::asio::const_buffer>& buffers, ProtocolVersion version, char* scratch) const;
+
+    // 本节点按自身消息头版本在线路上的总字节数
+    size_t totalSize() const { return payload ? headLength + payload->size() : bufferSize; }
+
     void setSendNode(const char* msg, int64_t max_len, short msg_id);
     virtual void clear() override;
 
     // 线程安全的设置方法
     bool safeSetSendNode(const char* msg, int64_t max_length, short msgid);
+
+    char header[MAX_HEAD_TOTAL_LEN] = {};
+    std::shared_ptr<const std::string> payload;
+
+    // 节点内消息头的编码版本
+    ProtocolVersion headerVersion = ProtocolVersion::LEGACY;
+
+    // 协议协商应答：写出本节点后，后续节点改用 switchVersion 编码
+    bool switchProtocol = false;
+    ProtocolVersion switchVersion = ProtocolVersion::LEGACY;
 };
\ No newline at end of file
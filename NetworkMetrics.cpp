@@ -0,0 +1,74 @@
+#include "NetworkMetrics.h"
+#include "Utils.h"
+
+void NetworkMetrics::recordWriteBatch(size_t nodes, size_t bytes) {
+    writeBatches.fetch_add(1, std::memory_order_relaxed);
+    writeBatchNodes.fetch_add(nodes, std::memory_order_relaxed);
+    writeBatchBytes.fetch_add(bytes, std::memory_order_relaxed);
+    batchNodesHistogram.record(nodes);
+    batchBytesHistogram.record(bytes);
+}
+
+void NetworkMetrics::setSocketProfile(const std::string& description) {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    if (!socketProfile.empty()) {
+        socketProfile += ", ";
+    }
+    socketProfile += description;
+}
+
+void NetworkMetrics::recordSocketProfileApplied(int failures) {
+    socketProfileApplied.fetch_add(1, std::memory_order_relaxed);
+    if (failures > 0) {
+        socketOptionFailures.fetch_add(failures, std::memory_order_relaxed);
+    }
+}
+
+void NetworkMetrics::logSnapshot() {
+    uint64_t batches = writeBatches.load(std::memory_order_relaxed);
+    uint64_t nodes = writeBatchNodes.load(std::memory_order_relaxed);
+    uint64_t bytes = writeBatchBytes.load(std::memory_order_relaxed);
+
+    if (batches > 0) {
+        // 合并比例 = 平均每次写系统调用携带的 SendNode 数量
+        LOG_INFO("NetworkMetrics: Write Batches: %llu, Coalescing Ratio: %0.2f, Avg Batch Bytes: %llu",
+            static_cast<unsigned long long>(batches),
+            static_cast<double>(nodes) / batches,
+            static_cast<unsigned long long>(bytes / batches));
+
+        LOG_INFO("NetworkMetrics: Batch Nodes p50/p99: %llu/%llu, Batch Bytes p50/p99: %llu/%llu",
+            static_cast<unsigned long long>(batchNodesHistogram.percentile(0.5)),
+            static_cast<unsigned long long>(batchNodesHistogram.percentile(0.99)),
+            static_cast<unsigned long long>(batchBytesHistogram.percentile(0.5)),
+            static_cast<unsigned long long>(batchBytesHistogram.percentile(0.99)));
+    }
+
+    uint64_t pauses = readPauses.exchange(0, std::memory_order_relaxed);
+
+    if (pauses > 0) {
+        LOG_INFO("NetworkMetrics: Read Pauses (flow control): %llu", static_cast<unsigned long long>(pauses));
+    }
+
+    uint64_t limit = rejectedLimit.exchange(0, std::memory_order_relaxed);
+    uint64_t rate = rejectedRate.exchange(0, std::memory_order_relaxed);
+    uint64_t errors = acceptErrors.exchange(0, std::memory_order_relaxed);
+    uint64_t acceptPaused = acceptPauses.exchange(0, std::memory_order_relaxed);
+
+    if (limit + rate + errors + acceptPaused > 0) {
+        LOG_INFO("NetworkMetrics: Rejected (limit/rate): %llu/%llu, Accept Errors: %llu, Accept Pauses: %llu",
+            static_cast<unsigned long long>(limit), static_cast<unsigned long long>(rate),
+            static_cast<unsigned long long>(errors), static_cast<unsigned long long>(acceptPaused));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(profileMutex);
+        if (!socketProfile.empty()) {
+            LOG_INFO("NetworkMetrics: Socket Profile: %s, Applied: %llu, Option Failures: %llu", socketProfile.c_str(),
+                static_cast<unsigned long long>(socketProfileApplied.load(std::memory_order_relaxed)),
+                static_cast<unsigned long long>(socketOptionFailures.load(std::memory_order_relaxed)));
+        }
+    }
+
+    batchNodesHistogram.reset();
+    batchBytesHistogram.reset();
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include "Histogram.h"
+
+// 网络层运行指标，由 AsioProactors 的监控线程周期性输出
+class NetworkMetrics {
+public:
+    static NetworkMetrics* getInstance() {
+        static NetworkMetrics instance;
+        return &instance;
+    }
+
+    NetworkMetrics(const NetworkMetrics& networkMetrics) = delete;
+
+    NetworkMetrics& operator=(const NetworkMetrics& networkMetrics) = delete;
+
+    // 记录一次合并写：本次写出的 SendNode 数量与字节数
+    void recordWriteBatch(size_t nodes, size_t bytes);
+
+    // 记录一次读端流控暂停
+    void recordReadPause() { readPauses.fetch_add(1, std::memory_order_relaxed); }
+
+    // 准入控制：拒绝的连接（超过连接上限/超过接受速率）、accept 错误、因积压暂停接受的次数
+    void recordConnectionRejected(bool rateLimited) {
+        (rateLimited ? rejectedRate : rejectedLimit).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void recordAcceptError() { acceptErrors.fetch_add(1, std::memory_order_relaxed); }
+
+    void recordAcceptPause() { acceptPauses.fetch_add(1, std::memory_order_relaxed); }
+
+    // 记录监听使用的 socket 配置，便于对比不同配置下的延迟与吞吐
+    void setSocketProfile(const std::string& description);
+
+    // 记录一次 socket 配置应用结果
+    void recordSocketProfileApplied(int failures);
+
+    // 输出当前指标并重置直方图
+    void logSnapshot();
+
+private:
+    NetworkMetrics() = default;
+
+    std::atomic<uint64_t> writeBatches{ 0 };
+
+    std::atomic<uint64_t> writeBatchNodes{ 0 };
+
+    std::atomic<uint64_t> writeBatchBytes{ 0 };
+
+    std::atomic<uint64_t> readPauses{ 0 };
+
+    std::atomic<uint64_t> rejectedLimit{ 0 };
+
+    std::atomic<uint64_t> rejectedRate{ 0 };
+
+    std::atomic<uint64_t> acceptErrors{ 0 };
+
+    std::atomic<uint64_t> acceptPauses{ 0 };
+
+    std::atomic<uint64_t> socketProfileApplied{ 0 };
+
+    std::atomic<uint64_t> socketOptionFailures{ 0 };
+
+    std::mutex profileMutex;
+
+    std::string socketProfile;
+
+    Histogram batchNodesHistogram;
+
+    Histogram batchBytesHistogram;
+};
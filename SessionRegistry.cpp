@@ -0,0 +1,224 @@
+#include "SessionRegistry.h"
+#include "CSession.h"
+
+namespace {
+
+    size_t roundUpPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+}
+
+SessionRegistry::Table::Table(size_t capacity)
+    : mask(capacity - 1),
+    keys(new std::atomic<uint64_t>[capacity]),
+    values(new std::atomic<std::shared_ptr<CSession>>[capacity]) {
+    for (size_t i = 0; i < capacity; i++) {
+        keys[i].store(EMPTY_KEY, std::memory_order_relaxed);
+    }
+}
+
+SessionRegistry::SessionRegistry(size_t capacity, size_t shardCount) {
+    shardCount = roundUpPowerOfTwo(shardCount == 0 ? 1 : shardCount);
+    shardMask = shardCount - 1;
+    shards = std::make_unique<Shard[]>(shardCount);
+
+    size_t shardCapacity = roundUpPowerOfTwo(capacity * 2 / shardCount);
+    if (shardCapacity < 16) shardCapacity = 16;
+
+    for (size_t i = 0; i < shardCount; i++) {
+        shards[i].current = std::make_unique<Table>(shardCapacity);
+        shards[i].table.store(shards[i].current.get(), std::memory_order_release);
+    }
+}
+
+SessionRegistry::~SessionRegistry() = default;
+
+void SessionRegistry::insertInto(Table& table, uint64_t sessionId, const std::shared_ptr<CSession>& session) {
+    size_t index = sessionId & table.mask;
+    size_t reusable = SIZE_MAX;
+
+    for (size_t probe = 0; probe <= table.mask; probe++, index = (index + 1) & table.mask) {
+        uint64_t key = table.keys[index].load(std::memory_order_relaxed);
+
+        if (key == sessionId) {
+            table.values[index].store(session);
+            return;
+        }
+        if (key == TOMBSTONE_KEY && reusable == SIZE_MAX) {
+            reusable = index;
+        }
+        if (key == EMPTY_KEY) {
+            break;
+        }
+    }
+
+    if (reusable == SIZE_MAX) {
+        reusable = index;
+        table.used++;
+    }
+    // 先写值再发布键，读者看到键时值已就绪
+    table.values[reusable].store(session);
+    table.keys[reusable].store(sessionId, std::memory_order_release);
+}
+
+void SessionRegistry::rehashIfNeeded(Shard& shard) {
+    Table* current = shard.table.load(std::memory_order_relaxed);
+    size_t capacity = current->mask + 1;
+
+    reclaim(shard);
+
+    if ((current->used + 1) * 4 <= capacity * 3) {
+        return;
+    }
+
+    // 存活元素超过一半时扩容，否则只是墓碑过多，按原容量重建
+    size_t newCapacity = (shard.live + 1) * 2 > capacity ? capacity * 2 : capacity;
+    std::unique_ptr<Table> table = std::make_unique<Table>(newCapacity);
+
+    for (size_t i = 0; i < capacity; i++) {
+        uint64_t key = current->keys[i].load(std::memory_order_relaxed);
+        if (key == EMPTY_KEY || key == TOMBSTONE_KEY) continue;
+        std::shared_ptr<CSession> session = current->values[i].load();
+        if (session) insertInto(*table, key, session);
+    }
+
+    shard.table.store(table.get());
+    shard.retired.push_back(std::move(shard.current));
+    shard.current = std::move(table);
+
+    reclaim(shard);
+}
+
+void SessionRegistry::reclaim(Shard& shard) {
+    // 表指针已替换（顺序一致），此时读者数为 0 则之后进入的读者只会读到新表
+    if (!shard.retired.empty() && shard.readers.load() == 0) {
+        shard.retired.clear();
+    }
+}
+
+void SessionRegistry::insert(const std::shared_ptr<CSession>& session) {
+    if (session == nullptr) return;
+
+    uint64_t sessionId = session->getSessionId();
+    Shard& shard = shardOf(sessionId);
+
+    std::lock_guard<std::mutex> lock(shard.mutexs);
+
+    if (find(sessionId) == nullptr) {
+        shard.live++;
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    rehashIfNeeded(shard);
+    insertInto(*shard.table.load(std::memory_order_relaxed), sessionId, session);
+}
+
+bool SessionRegistry::erase(uint64_t sessionId) {
+    Shard& shard = shardOf(sessionId);
+
+    std::lock_guard<std::mutex> lock(shard.mutexs);
+
+    reclaim(shard);
+
+    Table& table = *shard.table.load(std::memory_order_relaxed);
+    size_t index = sessionId & table.mask;
+
+    for (size_t probe = 0; probe <= table.mask; probe++, index = (index + 1) & table.mask) {
+        uint64_t key = table.keys[index].load(std::memory_order_relaxed);
+
+        if (key == EMPTY_KEY) {
+            return false;
+        }
+        if (key == sessionId) {
+            table.values[index].store(nullptr);
+            table.keys[index].store(TOMBSTONE_KEY, std::memory_order_release);
+            shard.live--;
+            count.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::shared_ptr<CSession> SessionRegistry::find(uint64_t sessionId) const {
+    Shard& shard = shardOf(sessionId);
+    ReadGuard guard(shard);
+
+    for (;;) {
+        Table* table = shard.table.load();
+        size_t index = sessionId & table->mask;
+
+        for (size_t probe = 0; probe <= table->mask; probe++, index = (index + 1) & table->mask) {
+            uint64_t key = table->keys[index].load(std::memory_order_acquire);
+
+            if (key == EMPTY_KEY) {
+                break;
+            }
+            if (key == sessionId) {
+                std::shared_ptr<CSession> session = table->values[index].load();
+                // 槽位可能已被删除或复用，需校验会话 ID
+                if (session && session->getSessionId() == sessionId) {
+                    return session;
+                }
+                break;
+            }
+        }
+
+        // 探测期间表被替换，则在新表上重试
+        if (shard.table.load() == table) {
+            return nullptr;
+        }
+    }
+}
+
+void SessionRegistry::collect(Shard& shard, std::vector<std::shared_ptr<CSession>>& sessions) {
+    ReadGuard guard(shard);
+    size_t begin = sessions.size();
+
+    for (;;) {
+        Table* table = shard.table.load();
+
+        for (size_t index = 0; index <= table->mask; index++) {
+            uint64_t key = table->keys[index].load(std::memory_order_acquire);
+            if (key == EMPTY_KEY || key == TOMBSTONE_KEY) continue;
+
+            std::shared_ptr<CSession> session = table->values[index].load();
+            if (session) sessions.push_back(std::move(session));
+        }
+
+        // 遍历期间发生扩容，旧表中可能缺少之后插入的会话，丢弃本分片结果后在新表上重来
+        if (shard.table.load() == table) {
+            return;
+        }
+        sessions.resize(begin);
+    }
+}
+
+void SessionRegistry::forEach(const std::function<void(const std::shared_ptr<CSession>&)>& func) const {
+    std::vector<std::shared_ptr<CSession>> sessions;
+
+    for (size_t i = 0; i <= shardMask; i++) {
+        sessions.clear();
+        collect(shards[i], sessions);
+
+        // 回调在读者登记之外执行，回调中插入或删除会话不会阻止旧表释放
+        for (const auto& session : sessions) {
+            func(session);
+        }
+    }
+}
+
+std::vector<std::shared_ptr<CSession>> SessionRegistry::snapshot() const {
+    std::vector<std::shared_ptr<CSession>> sessions;
+    sessions.reserve(size());
+
+    for (size_t i = 0; i <= shardMask; i++) {
+        collect(shards[i], sessions);
+    }
+
+    return sessions;
+}
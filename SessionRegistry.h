@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+class CSession;
+
+// 按会话 ID 分片的开放寻址（线性探测）会话表
+// 写操作（插入/删除/扩容）持有分片锁；查找与遍历不加锁：
+// 键数组连续存放便于探测，值为原子 shared_ptr；读者进入分片时登记，扩容替换下的旧表在分片没有读者时释放
+class SessionRegistry {
+public:
+    explicit SessionRegistry(size_t capacity = 1024, size_t shardCount = 64);
+
+    ~SessionRegistry();
+
+    SessionRegistry(const SessionRegistry& registry) = delete;
+
+    SessionRegistry& operator=(const SessionRegistry& registry) = delete;
+
+    // 插入或替换同 ID 的会话
+    void insert(const std::shared_ptr<CSession>& session);
+
+    bool erase(uint64_t sessionId);
+
+    std::shared_ptr<CSession> find(uint64_t sessionId) const;
+
+    // 当前所有会话的快照
+    std::vector<std::shared_ptr<CSession>> snapshot() const;
+
+    void forEach(const std::function<void(const std::shared_ptr<CSession>&)>& func) const;
+
+    size_t size() const { return count.load(std::memory_order_relaxed); }
+
+    // 0 与全 1 为保留键，会话 ID 生成时会跳过
+    static constexpr uint64_t EMPTY_KEY = 0;
+
+    static constexpr uint64_t TOMBSTONE_KEY = UINT64_MAX;
+
+private:
+    struct Table {
+        explicit Table(size_t capacity);
+
+        size_t mask;
+
+        // 已占用槽位数（含墓碑），用于决定何时扩容
+        size_t used = 0;
+
+        std::unique_ptr<std::atomic<uint64_t>[]> keys;
+
+        std::unique_ptr<std::atomic<std::shared_ptr<CSession>>[]> values;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutexs;
+
+        std::atomic<Table*> table{ nullptr };
+
+        // 正在探测或遍历本分片的读者数
+        std::atomic<size_t> readers{ 0 };
+
+        size_t live = 0;
+
+        std::unique_ptr<Table> current;
+
+        // 被替换的旧表，读者可能仍在探测，等到分片没有读者时释放
+        std::vector<std::unique_ptr<Table>> retired;
+    };
+
+    // 读者登记：先增加读者数再读取表指针，与 reclaim() 先替换表再检查读者数配对
+    struct ReadGuard {
+        explicit ReadGuard(Shard& shard) : shard(shard) { shard.readers.fetch_add(1); }
+        ~ReadGuard() { shard.readers.fetch_sub(1); }
+        Shard& shard;
+    };
+
+    Shard& shardOf(uint64_t sessionId) const { return shards[(sessionId >> 32) & shardMask]; }
+
+    // 持有分片锁时调用：负载过高时重建表（容量翻倍，或墓碑过多时原容量重建）
+    void rehashIfNeeded(Shard& shard);
+
+    // 持有分片锁时调用：分片没有读者时释放全部旧表
+    static void reclaim(Shard& shard);
+
+    // 遍历一个分片；遍历期间表被替换则重新遍历，保证不漏掉替换后的会话
+    static void collect(Shard& shard, std::vector<std::shared_ptr<CSession>>& sessions);
+
+    static void insertInto(Table& table, uint64_t sessionId, const std::shared_ptr<CSession>& session);
+
+    std::unique_ptr<Shard[]> shards;
+
+    size_t shardMask;
+
+    std::atomic<size_t> count{ 0 };
+};
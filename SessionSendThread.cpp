@@ -1,17 +1,22 @@
 #include "SessionSendThread.h"
 #include "CSession.h"
+#include "CpuTopology.h"
+#include "ThreadBudget.h"
 
 SessionSendThread::~SessionSendThread()
 {
 	stop();
 }
 
-SessionSendThread::SessionSendThread(size_t size):size(size),threadCount(size), isStop(false)
+SessionSendThread::SessionSendThread(size_t size):size(ThreadBudget::getInstance()->registerPool("SessionSendThread", size, size)),threadCount(this->size), isStop(false)
 {
+	CpuTopology::getInstance()->reserve("SessionSendThread", this->size);
 
-	for (int i = 0; i < size; i++) {
+	for (int i = 0; i < this->size; i++) {
 
-		threadPools.push_back(std::move(std::thread([this]() {
+		threadPools.push_back(std::move(std::thread([this, i]() {
+
+			CpuTopology::getInstance()->pinCurrentThread("SessionSendThread", i);
 
 			for (;;) {
 
@@ -0,0 +1,135 @@
+#include "SocketOptions.h"
+#include "ConfigMgr.h"
+#include "Utils.h"
+#if defined(__linux__)
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif
+
+SocketProfile SocketProfile::load(const std::string& name) {
+    SocketProfile profile;
+
+    if (name.empty()) {
+        return profile;
+    }
+
+    SectionInfo section = ConfigMgr::Inst()["SocketProfile." + name];
+
+    if (section._section_datas.empty()) {
+        LOG_WARNING("SocketProfile: section [SocketProfile.%s] not found, using system defaults", name.c_str());
+        return profile;
+    }
+
+    profile.name = name;
+
+    auto readValue = [&section](const std::string& key, int defaultValue) {
+        std::string value = section[key];
+        return value.empty() ? defaultValue : std::stoi(value);
+    };
+
+    profile.noDelay = section["NoDelay"] != "false";
+    profile.recvBufferSize = readValue("RecvBufferSize", profile.recvBufferSize);
+    profile.sendBufferSize = readValue("SendBufferSize", profile.sendBufferSize);
+    profile.quickAck = readValue("QuickAck", profile.quickAck);
+    profile.keepAlive = readValue("KeepAlive", profile.keepAlive);
+    profile.keepAliveIdle = readValue("KeepAliveIdle", profile.keepAliveIdle);
+    profile.keepAliveInterval = readValue("KeepAliveInterval", profile.keepAliveInterval);
+    profile.keepAliveCount = readValue("KeepAliveCount", profile.keepAliveCount);
+    profile.busyPoll = readValue("BusyPoll", profile.busyPoll);
+    profile.notSentLowat = readValue("NotSentLowat", profile.notSentLowat);
+
+    return profile;
+}
+
+uint32_t SocketProfile::apply(boost::asio::ip::tcp::socket& socket) const {
+    uint32_t failures = 0;
+    boost::system::error_code ec;
+
+    if (!enabled()) {
+        return failures;
+    }
+
+    socket.set_option(boost::asio::ip::tcp::no_delay(noDelay), ec);
+    if (ec) failures |= NO_DELAY;
+
+    if (recvBufferSize >= 0) {
+        socket.set_option(boost::asio::socket_base::receive_buffer_size(recvBufferSize), ec);
+        if (ec) failures |= RECV_BUFFER;
+    }
+
+    if (sendBufferSize >= 0) {
+        socket.set_option(boost::asio::socket_base::send_buffer_size(sendBufferSize), ec);
+        if (ec) failures |= SEND_BUFFER;
+    }
+
+    if (keepAlive >= 0) {
+        socket.set_option(boost::asio::socket_base::keep_alive(keepAlive != 0), ec);
+        if (ec) failures |= KEEP_ALIVE;
+    }
+
+#if defined(__linux__)
+    int fd = socket.native_handle();
+
+    auto setOption = [fd, &failures](int level, int option, int value, Option bit) {
+        if (value >= 0 && ::setsockopt(fd, level, option, &value, sizeof(value)) != 0) {
+            failures |= bit;
+        }
+    };
+
+    setOption(IPPROTO_TCP, TCP_QUICKACK, quickAck, QUICK_ACK);
+    setOption(IPPROTO_TCP, TCP_KEEPIDLE, keepAliveIdle, KEEP_IDLE);
+    setOption(IPPROTO_TCP, TCP_KEEPINTVL, keepAliveInterval, KEEP_INTERVAL);
+    setOption(IPPROTO_TCP, TCP_KEEPCNT, keepAliveCount, KEEP_COUNT);
+    setOption(SOL_SOCKET, SO_BUSY_POLL, busyPoll, BUSY_POLL);
+    setOption(IPPROTO_TCP, TCP_NOTSENT_LOWAT, notSentLowat, NOT_SENT_LOWAT);
+#endif
+
+    return failures;
+}
+
+std::string SocketProfile::optionNames(uint32_t options) {
+    static const char* const names[] = {
+        "NoDelay", "RecvBufferSize", "SendBufferSize", "KeepAlive", "QuickAck",
+        "KeepAliveIdle", "KeepAliveInterval", "KeepAliveCount", "BusyPoll", "NotSentLowat",
+    };
+
+    std::string text;
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if ((options & (1u << i)) == 0) continue;
+        if (!text.empty()) text += ", ";
+        text += names[i];
+    }
+
+    return text;
+}
+
+std::string SocketProfile::describe() const {
+    if (!enabled()) {
+        return "none";
+    }
+
+    std::string text = name + " {";
+
+    auto append = [&text](const char* key, int value) {
+        if (value < 0) return;
+        text += " ";
+        text += key;
+        text += "=";
+        text += std::to_string(value);
+    };
+
+    append("nodelay", noDelay ? 1 : 0);
+    append("rcvbuf", recvBufferSize);
+    append("sndbuf", sendBufferSize);
+    append("quickack", quickAck);
+    append("keepalive", keepAlive);
+    append("keepidle", keepAliveIdle);
+    append("keepintvl", keepAliveInterval);
+    append("keepcnt", keepAliveCount);
+    append("busypoll", busyPoll);
+    append("notsent_lowat", notSentLowat);
+
+    return text + " }";
+}
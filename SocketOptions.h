@@ -0,0 +1,60 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <string>
+
+// 已接受连接的 socket 参数配置，来自 config.ini 的 [SocketProfile.<name>] 节
+// 数值为 -1 表示保持系统默认值；平台不支持的选项会被跳过
+// 未选择配置（name 为空）时不修改已接受连接的任何选项
+struct SocketProfile {
+    // apply() 返回的失败选项位
+    enum Option : uint32_t {
+        NO_DELAY = 1u << 0,
+        RECV_BUFFER = 1u << 1,
+        SEND_BUFFER = 1u << 2,
+        KEEP_ALIVE = 1u << 3,
+        QUICK_ACK = 1u << 4,
+        KEEP_IDLE = 1u << 5,
+        KEEP_INTERVAL = 1u << 6,
+        KEEP_COUNT = 1u << 7,
+        BUSY_POLL = 1u << 8,
+        NOT_SENT_LOWAT = 1u << 9,
+    };
+
+    std::string name;
+
+    bool noDelay = true;
+
+    int recvBufferSize = -1;
+
+    int sendBufferSize = -1;
+
+    // TCP_QUICKACK 在 Linux 上不是持久选项，这里只影响连接建立后的首批确认
+    int quickAck = -1;
+
+    int keepAlive = -1;
+
+    int keepAliveIdle = -1;
+
+    int keepAliveInterval = -1;
+
+    int keepAliveCount = -1;
+
+    // SO_BUSY_POLL 微秒数
+    int busyPoll = -1;
+
+    int notSentLowat = -1;
+
+    static SocketProfile load(const std::string& name);
+
+    bool enabled() const { return !name.empty(); }
+
+    // 应用到 socket，返回设置失败的选项位（Option 的组合）
+    uint32_t apply(boost::asio::ip::tcp::socket& socket) const;
+
+    // 失败选项位对应的选项名，逗号分隔
+    static std::string optionNames(uint32_t options);
+
+    // 用于指标输出的简短描述
+    std::string describe() const;
+};
@@ -0,0 +1,183 @@
+#include "ThreadBudget.h"
+#include "ConfigMgr.h"
+#include "CpuTopology.h"
+#include "Utils.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#if defined(__linux__)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+    // 系统当前处于可运行状态的线程数（/proc/stat procs_running），不支持时返回 -1
+    long readRunQueue() {
+#if defined(__linux__)
+        std::ifstream file("/proc/stat");
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.compare(0, 14, "procs_running ") == 0) {
+                return std::stol(line.substr(14));
+            }
+        }
+#endif
+        return -1;
+    }
+
+}
+
+ThreadBudget::ThreadBudget() : lastSnapshot(std::chrono::steady_clock::now()) {
+    // config.ini [ThreadBudget] Threads：缺省为在线 CPU 数
+    SectionInfo section = ConfigMgr::Inst()["ThreadBudget"];
+
+    size_t cpus = CpuTopology::getInstance()->getCpus().size();
+    if (cpus == 0) cpus = std::max(1u, std::thread::hardware_concurrency());
+
+    budget = section["Threads"].empty() ? cpus : static_cast<size_t>(std::stoul(section["Threads"]));
+    if (budget == 0) budget = cpus;
+
+    LOG_INFO("ThreadBudget: %zu threads across %zu CPUs", budget, cpus);
+
+#if defined(__linux__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        lastVoluntary = static_cast<uint64_t>(usage.ru_nvcsw);
+        lastInvoluntary = static_cast<uint64_t>(usage.ru_nivcsw);
+    }
+#endif
+}
+
+void ThreadBudget::updateShares() {
+    size_t totalWeight = 0;
+    for (const auto& [name, usage] : pools) {
+        totalWeight += usage.weight;
+    }
+    for (auto& [name, usage] : pools) {
+        usage.share = totalWeight == 0 ? 0 : std::max<size_t>(1, budget * usage.weight / totalWeight);
+    }
+}
+
+size_t ThreadBudget::configuredWeight(const std::string& pool) const {
+    std::string value = ConfigMgr::Inst()["ThreadBudget"][pool];
+    return value.empty() ? 1 : static_cast<size_t>(std::stoul(value));
+}
+
+size_t ThreadBudget::pendingWeight() const {
+    size_t weight = 0;
+    for (const auto& [key, value] : ConfigMgr::Inst()["ThreadBudget"]._section_datas) {
+        if (key == "Threads" || value.empty() || pools.count(key) != 0) continue;
+        weight += static_cast<size_t>(std::stoul(value));
+    }
+    return weight;
+}
+
+size_t ThreadBudget::registerPool(const std::string& pool, size_t minSize, size_t maxSize) {
+    std::lock_guard<std::mutex> lock(mutexs);
+
+    PoolUsage& usage = pools[pool];
+    usage.weight = configuredWeight(pool);
+    usage.maxSize = maxSize;
+    updateShares();
+
+    size_t totalWeight = pendingWeight();
+    for (const auto& [name, other] : pools) {
+        totalWeight += other.weight;
+    }
+    size_t startShare = totalWeight == 0 ? 0 : budget * usage.weight / totalWeight;
+
+    size_t granted = std::max<size_t>(1, std::min(minSize, startShare));
+    usage.used = granted;
+    used += granted;
+
+    if (granted < minSize) {
+        LOG_INFO("ThreadBudget: %s starts with %zu threads (requested %zu, share %zu of %zu)", pool.c_str(), granted, minSize, std::max<size_t>(1, startShare), budget);
+    }
+
+    return granted;
+}
+
+size_t ThreadBudget::acquire(const std::string& pool, size_t count) {
+    std::lock_guard<std::mutex> lock(mutexs);
+
+    auto iter = pools.find(pool);
+    if (iter == pools.end()) return 0;
+    PoolUsage& usage = iter->second;
+
+    // 预算有剩余时直接批准；份额之内的线程池在预算用尽时也可借用，由超出份额者随后让出
+    size_t free = budget > used ? budget - used : 0;
+    size_t belowShare = usage.share > usage.used ? usage.share - usage.used : 0;
+    size_t granted = std::min(count, std::max(free, belowShare));
+
+    usage.used += granted;
+    used += granted;
+
+    size_t previousDemand = usage.demand;
+    usage.demand = count - granted;
+
+    if (usage.demand > 0 && previousDemand == 0) {
+        LOG_WARNING("ThreadBudget: %s asked for %zu threads, granted %zu (used %zu/%zu, share %zu)", pool.c_str(), count, granted, used, budget, usage.share);
+    }
+
+    return granted;
+}
+
+void ThreadBudget::release(const std::string& pool, size_t count) {
+    std::lock_guard<std::mutex> lock(mutexs);
+
+    auto iter = pools.find(pool);
+    if (iter == pools.end()) return;
+    PoolUsage& usage = iter->second;
+    count = std::min(count, usage.used);
+    usage.used -= count;
+    used -= count;
+}
+
+size_t ThreadBudget::surplus(const std::string& pool) const {
+    std::lock_guard<std::mutex> lock(mutexs);
+
+    auto iter = pools.find(pool);
+    if (iter == pools.end() || iter->second.used <= iter->second.share || used <= budget) {
+        // 预算未超出时份额不生效
+        return 0;
+    }
+
+    // 份额之内的线程池借用预算后总量超出，由超出份额者归还
+    return std::min(iter->second.used - iter->second.share, used - budget);
+}
+
+void ThreadBudget::logSnapshot() {
+    std::string text;
+    {
+        std::lock_guard<std::mutex> lock(mutexs);
+        for (const auto& [name, usage] : pools) {
+            char item[128];
+            snprintf(item, sizeof(item), "%s%s %zu/%zu", text.empty() ? "" : ", ", name.c_str(), usage.used, usage.share);
+            text += item;
+        }
+        LOG_INFO("ThreadBudget: Used %zu/%zu (used/share: %s)", used, budget, text.c_str());
+    }
+
+#if defined(__linux__)
+    struct rusage usage;
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - lastSnapshot).count();
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0 && seconds > 0) {
+        uint64_t voluntary = static_cast<uint64_t>(usage.ru_nvcsw);
+        uint64_t involuntary = static_cast<uint64_t>(usage.ru_nivcsw);
+        long runQueue = readRunQueue();
+        size_t cpus = std::max<size_t>(1, CpuTopology::getInstance()->getCpus().size());
+
+        // 非自愿切换（时间片用完被抢占）持续偏高说明可运行线程多于核心
+        LOG_INFO("ThreadBudget: Context Switches/s voluntary/involuntary: %0.0f/%0.0f, Run Queue: %ld (%0.2f per CPU)",
+            (voluntary - lastVoluntary) / seconds, (involuntary - lastInvoluntary) / seconds,
+            runQueue, runQueue < 0 ? 0.0 : static_cast<double>(runQueue) / cpus);
+
+        lastVoluntary = voluntary;
+        lastInvoluntary = involuntary;
+    }
+    lastSnapshot = now;
+#endif
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+// 进程级线程预算：已登记的线程池（AsioProactors、LogicSystem 等）共享同一份预算，
+// 默认每个在线 CPU 一个线程，只在已登记的线程池之间按 config.ini [ThreadBudget] 中的权重（缺省为 1）划分份额
+// 线程池在份额内可自由扩缩；预算用尽时，超出份额的线程池需要让出线程给仍在份额之下且有扩容需求的线程池
+class ThreadBudget {
+public:
+    static ThreadBudget* getInstance() {
+        static ThreadBudget instance;
+        return &instance;
+    }
+
+    ThreadBudget(const ThreadBudget& budget) = delete;
+
+    ThreadBudget& operator=(const ThreadBudget& budget) = delete;
+
+    // 线程池启动时登记并重新划分份额，返回实际可用的常驻线程数：不超过 minSize 与启动份额，至少为 1
+    // 启动份额把配置了权重、尚未登记的线程池计算在内，避免先登记者在其他线程池启动前占满预算
+    size_t registerPool(const std::string& pool, size_t minSize, size_t maxSize);
+
+    // 申请增加 count 个线程，返回批准的数量：预算有剩余，或本线程池仍在份额之内时批准
+    size_t acquire(const std::string& pool, size_t count);
+
+    void release(const std::string& pool, size_t count);
+
+    // 预算被份额之内的线程池借用而超出时，本线程池超出份额、应让出的线程数
+    size_t surplus(const std::string& pool) const;
+
+    size_t getBudget() const { return budget; }
+
+    // 输出各线程池占用与份额，以及进程上下文切换速率和系统运行队列长度
+    void logSnapshot();
+
+private:
+    ThreadBudget();
+
+    struct PoolUsage {
+        size_t weight = 1;
+        size_t share = 0;
+        size_t used = 0;
+        size_t maxSize = 0;
+        // 最近一次未被满足的扩容数量，用于只在首次受限时写日志
+        size_t demand = 0;
+    };
+
+    // 按权重在已登记的线程池之间重新计算份额，持有 mutexs 时调用
+    void updateShares();
+
+    // config.ini [ThreadBudget] <pool>，未配置时为 1
+    size_t configuredWeight(const std::string& pool) const;
+
+    // 配置了权重但尚未登记的线程池的权重之和，持有 mutexs 时调用
+    size_t pendingWeight() const;
+
+    size_t budget;
+
+    size_t used = 0;
+
+    std::map<std::string, PoolUsage> pools;
+
+    mutable std::mutex mutexs;
+
+    uint64_t lastVoluntary = 0;
+
+    uint64_t lastInvoluntary = 0;
+
+    std::chrono::steady_clock::time_point lastSnapshot;
+};
@@ -0,0 +1,182 @@
+#include "TimingWheel.h"
+#include "ConfigMgr.h"
+
+boost::asio::execution_context::id TimingWheel::id;
+
+TimerNode::~TimerNode() {
+    TimingWheel::cancel(*this);
+}
+
+TimingWheel::TimingWheel(boost::asio::io_context& ioContext)
+    : boost::asio::execution_context::service(ioContext), timer(ioContext), tickDuration(100) {
+
+    SectionInfo section = ConfigMgr::Inst()["TimingWheel"];
+
+    size_t slotCount = 512;
+
+    if (!section["TickMs"].empty()) tickDuration = std::chrono::milliseconds(std::max(1, std::stoi(section["TickMs"])));
+
+    if (!section["Slots"].empty()) slotCount = std::max<size_t>(2, std::stoull(section["Slots"]));
+
+    size_t capacity = 1;
+    while (capacity < slotCount) capacity <<= 1;
+
+    slots.assign(capacity, nullptr);
+    slotMask = capacity - 1;
+}
+
+TimingWheel::~TimingWheel() = default;
+
+void TimingWheel::shutdown() {
+    // io_context 销毁时先于挂起的协程帧析构执行，摘除全部节点使之后的 cancel 成为空操作
+    for (TimerNode*& head : slots) {
+        while (head != nullptr) {
+            TimerNode* node = head;
+            head = node->next;
+            node->prev = nullptr;
+            node->next = nullptr;
+            node->wheel = nullptr;
+        }
+    }
+
+    armedCount = 0;
+
+    boost::system::error_code ec;
+    timer.cancel(ec);
+}
+
+void TimingWheel::arm(TimerNode& node, std::chrono::milliseconds timeout) {
+    cancel(node);
+
+    uint64_t ticks = (timeout.count() + tickDuration.count() - 1) / tickDuration.count();
+    if (ticks == 0) ticks = 1;
+
+    node.rounds = (ticks - 1) / slots.size();
+
+    link(node, (currentTick + ticks) & slotMask);
+
+    if (!ticking) {
+        ticking = true;
+        lastTick = std::chrono::steady_clock::now();
+        scheduleTick();
+    }
+}
+
+void TimingWheel::cancel(TimerNode& node) {
+    if (node.wheel != nullptr) {
+        node.wheel->unlink(node);
+    }
+
+    if (node.expiring != nullptr) {
+        node.expiring->forget(node);
+    }
+}
+
+void TimingWheel::forget(TimerNode& node) {
+    // 只有同一 tick 中较早的回调取消了较晚到期的节点时才会走到这里，到期列表通常很短
+    for (TimerNode*& entry : expired) {
+        if (entry == &node) {
+            entry = nullptr;
+        }
+    }
+
+    node.expiring = nullptr;
+}
+
+void TimingWheel::link(TimerNode& node, size_t slot) {
+    node.wheel = this;
+    node.slot = slot;
+    node.prev = nullptr;
+    node.next = slots[slot];
+
+    if (node.next != nullptr) {
+        node.next->prev = &node;
+    }
+
+    slots[slot] = &node;
+    armedCount++;
+}
+
+void TimingWheel::unlink(TimerNode& node) {
+    if (node.prev != nullptr) {
+        node.prev->next = node.next;
+    }
+    else {
+        slots[node.slot] = node.next;
+    }
+
+    if (node.next != nullptr) {
+        node.next->prev = node.prev;
+    }
+
+    node.prev = nullptr;
+    node.next = nullptr;
+    node.wheel = nullptr;
+    armedCount--;
+}
+
+void TimingWheel::scheduleTick() {
+    timer.expires_at(lastTick + tickDuration);
+
+    timer.async_wait([this](const boost::system::error_code& ec) {
+        if (ec) {
+            ticking = false;
+            return;
+        }
+        onTick();
+    });
+}
+
+void TimingWheel::onTick() {
+    auto now = std::chrono::steady_clock::now();
+    // 线程繁忙导致回调延迟时补齐错过的 tick
+    while (lastTick + tickDuration <= now) {
+        lastTick += tickDuration;
+        advance();
+    }
+
+    if (armedCount == 0) {
+        ticking = false;
+        return;
+    }
+
+    scheduleTick();
+}
+
+void TimingWheel::advance() {
+    currentTick++;
+
+    size_t slot = currentTick & slotMask;
+
+    // 先摘下本槽位全部到期节点再回调，回调中可以安全地 arm/cancel 任意节点
+    expired.clear();
+
+    for (TimerNode* node = slots[slot]; node != nullptr;) {
+        TimerNode* next = node->next;
+
+        if (node->rounds == 0) {
+            unlink(*node);
+            node->expiring = this;
+            expired.push_back(node);
+        }
+        else {
+            node->rounds--;
+        }
+
+        node = next;
+    }
+
+    for (size_t i = 0; i < expired.size(); i++) {
+        // 前面的回调取消、重新设置或释放了该节点时，表项已被 forget() 置空
+        TimerNode* node = expired[i];
+        if (node == nullptr) {
+            continue;
+        }
+
+        // 回调中可能释放节点本身，回调后不再访问
+        node->expiring = nullptr;
+        if (node->onExpire) {
+            node->onExpire();
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class TimingWheel;
+
+// 侵入式定时器节点，由使用者持有；arm/cancel 只能在所属 io_context 的线程上调用
+class TimerNode {
+public:
+    TimerNode() = default;
+
+    // 仍处于设置状态时从时间轮上摘除
+    ~TimerNode();
+
+    TimerNode(const TimerNode& node) = delete;
+
+    TimerNode& operator=(const TimerNode& node) = delete;
+
+    bool isArmed() const { return wheel != nullptr; }
+
+    // 在 io_context 线程上、节点摘除后调用
+    std::function<void()> onExpire;
+
+private:
+    friend class TimingWheel;
+
+    TimerNode* prev = nullptr;
+
+    TimerNode* next = nullptr;
+
+    TimingWheel* wheel = nullptr;
+
+    // 已在本 tick 到期、等待回调的时间轮；回调前被 cancel/arm/析构时置空，不再回调
+    TimingWheel* expiring = nullptr;
+
+    size_t slot = 0;
+
+    // 还需经过的整圈数
+    uint64_t rounds = 0;
+};
+
+// 每个 io_context 一个的哈希时间轮，arm/cancel 均为 O(1)，只在有定时器时驱动一个 steady_timer
+// 通过 TimingWheel::of(ioContext) 获取，精度为一个 tick，配置来自 config.ini [TimingWheel]
+class TimingWheel : public boost::asio::execution_context::service {
+public:
+    static boost::asio::execution_context::id id;
+
+    explicit TimingWheel(boost::asio::io_context& ioContext);
+
+    ~TimingWheel();
+
+    static TimingWheel& of(boost::asio::io_context& ioContext) {
+        return boost::asio::use_service<TimingWheel>(ioContext);
+    }
+
+    // 设置（或重新设置）超时，到期后调用 node.onExpire
+    void arm(TimerNode& node, std::chrono::milliseconds timeout);
+
+    // 取消节点所在时间轮上的定时器，节点未设置时无操作
+    static void cancel(TimerNode& node);
+
+    size_t size() const { return armedCount; }
+
+private:
+    void shutdown() override;
+
+    void link(TimerNode& node, size_t slot);
+
+    void unlink(TimerNode& node);
+
+    // 从本 tick 的到期列表中移除节点，节点随后可能被释放
+    void forget(TimerNode& node);
+
+    void scheduleTick();
+
+    void onTick();
+
+    void advance();
+
+    boost::asio::steady_timer timer;
+
+    std::chrono::milliseconds tickDuration;
+
+    std::chrono::steady_clock::time_point lastTick;
+
+    std::vector<TimerNode*> slots;
+
+    std::vector<TimerNode*> expired;
+
+    size_t slotMask;
+
+    uint64_t currentTick = 0;
+
+    size_t armedCount = 0;
+
+    bool ticking = false;
+};
@@ -0,0 +1,278 @@
+// 连接风暴下 accept 路径的对比：按固定速率新建连接、立即以 RST 关闭，测量服务端的 accept 吞吐与延迟
+//   single    - 与 CServer 的 AcceptMode = single 相同：一个监听 socket 在独立线程上 accept，连接轮流分配到 I/O 线程
+//   reuseport - 与 AcceptMode = reuseport 相同：每个 I/O 线程一个 SO_REUSEPORT 监听 socket，由内核按四元组哈希分配
+//   steering  - 在 reuseport 的基础上挂载与 ReusePortCpuSteering 相同的 CBPF 程序，按处理软中断的 CPU 选择监听 socket
+// accept 延迟为客户端发起 connect 到服务端 accept 完成的时间，包含握手与在 accept 队列中的等待；
+// 客户端先 bind 取得本地端口并记录发起时间，服务端按对端端口查到该时间
+// 用法：AcceptBench [single|reuseport|steering] [每秒连接数] [秒数] [服务端线程数] [客户端线程数] [最大在途连接数]
+#include <utility>
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <linux/filter.h>
+#include <sys/socket.h>
+#endif
+
+namespace {
+
+	using boost::asio::ip::tcp;
+
+	using Clock = std::chrono::steady_clock;
+
+	int64_t nowNanos() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+	}
+
+	// 按客户端本地端口记录 connect 发起时间，端口在连接关闭前不会被复用
+	std::vector<std::atomic<int64_t>> connectStart(65536);
+
+	std::atomic<bool> measuring{ true };
+
+	// 每个服务端线程各自记录，结束后合并
+	struct AcceptStats {
+		std::vector<uint32_t> latencies;
+		uint64_t accepted = 0;
+	};
+
+	void openAcceptor(tcp::acceptor& acceptor, const tcp::endpoint& endpoint, bool reusePort) {
+		acceptor.open(endpoint.protocol());
+		acceptor.set_option(tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+		if (reusePort) {
+			acceptor.set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+		}
+#endif
+		acceptor.bind(endpoint);
+		acceptor.listen(boost::asio::socket_base::max_listen_connections);
+	}
+
+	void record(tcp::socket& socket, AcceptStats& stats) {
+		boost::system::error_code ec;
+		tcp::endpoint remote = socket.remote_endpoint(ec);
+		if (!ec && measuring.load(std::memory_order_relaxed)) {
+			int64_t start = connectStart[remote.port()].load(std::memory_order_acquire);
+			if (start != 0) {
+				stats.latencies.push_back(static_cast<uint32_t>((nowNanos() - start) / 1000));
+			}
+			stats.accepted++;
+		}
+		socket.close(ec);
+	}
+
+	// single：accept 线程上接受，连接落在轮流选出的 I/O 线程的 io_context 上，在该线程上统计并关闭
+	boost::asio::awaitable<void> acceptSingle(tcp::acceptor& acceptor, std::vector<std::unique_ptr<boost::asio::io_context>>& contexts,
+		std::vector<AcceptStats>& stats) {
+		size_t next = 0;
+		for (;;) {
+			size_t index = next++ % contexts.size();
+			auto peer = std::make_shared<tcp::socket>(*contexts[index]);
+			boost::system::error_code ec;
+			co_await acceptor.async_accept(*peer, boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+			if (ec == boost::asio::error::operation_aborted) co_return;
+			if (ec) continue;
+			boost::asio::post(*contexts[index], [peer, &stats, index]() { record(*peer, stats[index]); });
+		}
+	}
+
+	// reuseport：每个 I/O 线程在自己的监听 socket 上接受，连接不跨线程
+	boost::asio::awaitable<void> acceptLocal(tcp::acceptor& acceptor, AcceptStats& stats) {
+		for (;;) {
+			tcp::socket peer(acceptor.get_executor());
+			boost::system::error_code ec;
+			co_await acceptor.async_accept(peer, boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+			if (ec == boost::asio::error::operation_aborted) co_return;
+			if (ec) continue;
+			record(peer, stats);
+		}
+	}
+
+	bool attachCpuSteering(tcp::acceptor& acceptor, size_t count) {
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+		struct sock_filter code[] = {
+			{ BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+			{ BPF_ALU | BPF_MOD | BPF_K, 0, 0, static_cast<uint32_t>(count) },
+			{ BPF_RET | BPF_A, 0, 0, 0 },
+		};
+		struct sock_fprog program = { static_cast<unsigned short>(sizeof(code) / sizeof(code[0])), code };
+		return setsockopt(acceptor.native_handle(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == 0;
+#else
+		return false;
+#endif
+	}
+
+	struct ClientStats {
+		uint64_t started = 0;
+		uint64_t failed = 0;
+	};
+
+	// 建立一个连接后立即以 RST 关闭（SO_LINGER 0），两端都不留 TIME_WAIT，端口可以持续复用
+	boost::asio::awaitable<void> connectOnce(tcp::endpoint endpoint, std::atomic<size_t>& inFlight, ClientStats& stats) {
+		auto executor = co_await boost::asio::this_coro::executor;
+		tcp::socket socket(executor);
+		boost::system::error_code ec;
+		socket.open(endpoint.protocol(), ec);
+		if (!ec) socket.bind(tcp::endpoint(endpoint.address(), 0), ec);
+		unsigned short port = ec ? 0 : socket.local_endpoint(ec).port();
+		if (!ec) {
+			connectStart[port].store(nowNanos(), std::memory_order_release);
+			co_await socket.async_connect(endpoint, boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+		}
+		if (ec) stats.failed++;
+		// 等服务端统计完再复用端口：服务端按端口查表，关闭前把记录清零会丢失样本
+		boost::asio::steady_timer settle(executor, std::chrono::milliseconds(20));
+		co_await settle.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+		if (port != 0) connectStart[port].store(0, std::memory_order_release);
+		socket.set_option(boost::asio::socket_base::linger(true, 0), ec);
+		socket.close(ec);
+		inFlight.fetch_sub(1);
+	}
+
+	// 每毫秒按配额发起新连接，在途连接达到上限时暂停发起，实际速率低于目标时说明服务端已饱和
+	boost::asio::awaitable<void> generate(tcp::endpoint endpoint, double rate, Clock::time_point deadline, size_t maxInFlight,
+		std::atomic<size_t>& inFlight, ClientStats& stats) {
+		auto executor = co_await boost::asio::this_coro::executor;
+		boost::asio::steady_timer timer(executor);
+		auto begin = Clock::now();
+		uint64_t due = 0;
+		while (Clock::now() < deadline) {
+			due = static_cast<uint64_t>(std::chrono::duration<double>(Clock::now() - begin).count() * rate);
+			while (stats.started < due && inFlight.load() < maxInFlight) {
+				stats.started++;
+				inFlight.fetch_add(1);
+				boost::asio::co_spawn(executor, connectOnce(endpoint, inFlight, stats), boost::asio::detached);
+			}
+			timer.expires_after(std::chrono::milliseconds(1));
+			co_await timer.async_wait(boost::asio::use_awaitable);
+		}
+	}
+
+	uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+		if (sorted.empty()) return 0;
+		return sorted[static_cast<size_t>(p * static_cast<double>(sorted.size() - 1))];
+	}
+
+}
+
+int main(int argc, char* argv[]) {
+	std::string mode = argc > 1 ? argv[1] : "single";
+	double rate = argc > 2 ? std::atof(argv[2]) : 10000;
+	int seconds = argc > 3 ? std::atoi(argv[3]) : 5;
+	size_t serverThreads = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 2;
+	size_t clientThreads = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 2;
+	size_t maxInFlight = argc > 6 ? std::strtoull(argv[6], nullptr, 10) : 1024;
+	if ((mode != "single" && mode != "reuseport" && mode != "steering") || rate <= 0 || seconds <= 0 || serverThreads == 0 || clientThreads == 0 || maxInFlight == 0) {
+		std::fprintf(stderr, "usage: %s [single|reuseport|steering] [connections/s] [seconds] [server threads] [client threads] [max in flight]\n", argv[0]);
+		return 1;
+	}
+
+	// 服务端
+	std::vector<std::unique_ptr<boost::asio::io_context>> serverContexts;
+	std::vector<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> works;
+	for (size_t i = 0; i < serverThreads; i++) {
+		serverContexts.push_back(std::make_unique<boost::asio::io_context>(1));
+		works.push_back(boost::asio::make_work_guard(*serverContexts.back()));
+	}
+	std::vector<AcceptStats> acceptStats(serverThreads);
+	boost::asio::io_context acceptContext(1);
+	std::vector<std::unique_ptr<tcp::acceptor>> acceptors;
+	tcp::endpoint endpoint(boost::asio::ip::make_address("127.0.0.1"), 0);
+
+	try {
+		if (mode == "single") {
+			acceptors.push_back(std::make_unique<tcp::acceptor>(acceptContext));
+			openAcceptor(*acceptors.back(), endpoint, false);
+			endpoint = acceptors.back()->local_endpoint();
+			boost::asio::co_spawn(acceptContext, acceptSingle(*acceptors.back(), serverContexts, acceptStats), boost::asio::detached);
+		}
+		else {
+			// 第一个监听 socket 决定端口，其余绑定到同一端口
+			for (size_t i = 0; i < serverThreads; i++) {
+				acceptors.push_back(std::make_unique<tcp::acceptor>(*serverContexts[i]));
+				openAcceptor(*acceptors.back(), endpoint, true);
+				endpoint = acceptors.front()->local_endpoint();
+			}
+			if (mode == "steering" && !attachCpuSteering(*acceptors.front(), serverThreads)) {
+				std::fprintf(stderr, "SO_ATTACH_REUSEPORT_CBPF failed, falling back to hash distribution\n");
+			}
+			for (size_t i = 0; i < serverThreads; i++) {
+				boost::asio::co_spawn(*serverContexts[i], acceptLocal(*acceptors[i], acceptStats[i]), boost::asio::detached);
+			}
+		}
+	}
+	catch (const boost::system::system_error& e) {
+		std::fprintf(stderr, "failed to open acceptors: %s\n", e.what());
+		return 1;
+	}
+
+	std::vector<std::thread> serverPool;
+	serverPool.emplace_back([&acceptContext]() { acceptContext.run(); });
+	for (auto& context : serverContexts) {
+		serverPool.emplace_back([&context]() { context->run(); });
+	}
+
+	// 客户端
+	std::vector<std::unique_ptr<boost::asio::io_context>> clientContexts;
+	std::vector<ClientStats> clientStats(clientThreads);
+	std::atomic<size_t> inFlight{ 0 };
+	auto begin = Clock::now();
+	auto deadline = begin + std::chrono::seconds(seconds);
+	for (size_t i = 0; i < clientThreads; i++) {
+		clientContexts.push_back(std::make_unique<boost::asio::io_context>(1));
+		boost::asio::co_spawn(*clientContexts.back(), generate(endpoint, rate / clientThreads, deadline, maxInFlight / clientThreads + 1, inFlight, clientStats[i]),
+			boost::asio::detached);
+	}
+	std::vector<std::thread> clientPool;
+	for (auto& context : clientContexts) {
+		clientPool.emplace_back([&context]() { context->run(); });
+	}
+	for (auto& thread : clientPool) {
+		thread.join();
+	}
+	double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+
+	// 客户端全部结束后停止统计，监听 socket 随 io_context 停止后析构
+	measuring.store(false);
+	works.clear();
+	acceptContext.stop();
+	for (auto& context : serverContexts) {
+		context->stop();
+	}
+	for (auto& thread : serverPool) {
+		thread.join();
+	}
+
+	std::vector<uint32_t> merged;
+	uint64_t accepted = 0;
+	std::string perThread;
+	for (const AcceptStats& stats : acceptStats) {
+		merged.insert(merged.end(), stats.latencies.begin(), stats.latencies.end());
+		accepted += stats.accepted;
+		perThread += (perThread.empty() ? "" : "/") + std::to_string(stats.accepted);
+	}
+	std::sort(merged.begin(), merged.end());
+
+	uint64_t started = 0;
+	uint64_t failed = 0;
+	for (const ClientStats& stats : clientStats) {
+		started += stats.started;
+		failed += stats.failed;
+	}
+
+	std::printf("mode: %s, target: %0.0f conn/s, acceptors: %zu, server/client threads: %zu/%zu\n",
+		mode.c_str(), rate, acceptors.size(), serverThreads, clientThreads);
+	std::printf("connects started: %llu, failed: %llu, accepted: %llu (per I/O thread %s), accepts/s: %0.0f\n",
+		static_cast<unsigned long long>(started), static_cast<unsigned long long>(failed), static_cast<unsigned long long>(accepted),
+		perThread.c_str(), static_cast<double>(accepted) / elapsed);
+	std::printf("accept latency p50/p99/p999: %u/%u/%uus\n", percentile(merged, 0.5), percentile(merged, 0.99), percentile(merged, 0.999));
+
+	return accepted == 0 ? 1 : 0;
+}
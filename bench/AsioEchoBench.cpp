@@ -0,0 +1,183 @@
+// Boost.Asio 本身的 epoll 与 io_uring 后端对比：同一份源码分别以两种后端编译（见 bench/CMakeLists.txt 的 BENCH_IO_URING）
+// 只测量裸 Asio 套接字上的回显，不经过 AsioProactors、CSession 与 FrameCodec，结果反映后端本身的差异，
+// 不代表本服务器在两种后端下的表现
+// 服务端按 AsioProactors 的方式每线程一个 io_context 轮流分配连接，客户端在独立的 io_context 上保持固定在途请求
+// 服务端 io_context 的并发提示可选 safe（1）或 unsafe_io（BOOST_ASIO_CONCURRENCY_HINT_UNSAFE_IO），与 [AsioProactors] ConcurrencyHint 对应；
+// 两种模式都与服务器一样在 accept 线程上接受连接，再经 ContextHandoff 交给所属线程注册
+// 用法：AsioEchoBench [连接数] [秒数] [消息字节数] [服务端线程数] [客户端线程数] [safe|unsafe_io]
+// 输出吞吐与往返延迟 p50/p99/p999，两次运行的结果直接对比
+#include <utility>
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ContextHandoff.h"
+
+namespace {
+
+	using boost::asio::ip::tcp;
+
+	const char* backendName() {
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+		return "io_uring";
+#else
+		return "epoll";
+#endif
+	}
+
+	boost::asio::awaitable<void> echo(tcp::socket socket) {
+		std::vector<char> buffer(64 * 1024);
+		boost::system::error_code ec;
+		for (;;) {
+			size_t n = co_await socket.async_read_some(boost::asio::buffer(buffer), boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+			if (ec) co_return;
+			co_await boost::asio::async_write(socket, boost::asio::buffer(buffer.data(), n), boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+			if (ec) co_return;
+		}
+	}
+
+	// 与 CServer::handoffAccepted 相同：释放原生句柄，在目标线程上重新包装，UNSAFE_IO 下 reactor 注册只能在所属线程执行
+	boost::asio::awaitable<void> accept(tcp::acceptor& acceptor, std::vector<std::unique_ptr<boost::asio::io_context>>& contexts,
+		std::vector<std::unique_ptr<ContextHandoff>>& handoffs) {
+		size_t next = 0;
+		for (;;) {
+			size_t index = next++ % contexts.size();
+			tcp::socket peer(acceptor.get_executor());
+			boost::system::error_code ec;
+			co_await acceptor.async_accept(peer, boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+			if (ec) co_return;
+			tcp::socket::native_handle_type handle = peer.release(ec);
+			if (ec) continue;
+			boost::asio::io_context& target = *contexts[index];
+			handoffs[index]->push([&target, handle]() {
+				tcp::socket socket(target);
+				boost::system::error_code ec;
+				socket.assign(tcp::v4(), handle, ec);
+				if (ec) return;
+				socket.set_option(tcp::no_delay(true), ec);
+				boost::asio::co_spawn(target, echo(std::move(socket)), boost::asio::detached);
+			});
+		}
+	}
+
+	// 每个连接一个请求在途：写出消息后等待完整回显再发下一条
+	boost::asio::awaitable<void> client(tcp::endpoint endpoint, size_t payloadSize, std::chrono::steady_clock::time_point deadline,
+		std::vector<uint32_t>& latencies, std::atomic<size_t>& finished) {
+		auto executor = co_await boost::asio::this_coro::executor;
+		tcp::socket socket(executor);
+		boost::system::error_code ec;
+		co_await socket.async_connect(endpoint, boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+		if (!ec) {
+			socket.set_option(tcp::no_delay(true));
+			std::vector<char> request(payloadSize, 'x');
+			std::vector<char> response(payloadSize);
+			while (std::chrono::steady_clock::now() < deadline) {
+				auto start = std::chrono::steady_clock::now();
+				co_await boost::asio::async_write(socket, boost::asio::buffer(request), boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+				if (ec) break;
+				co_await boost::asio::async_read(socket, boost::asio::buffer(response), boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+				if (ec) break;
+				latencies.push_back(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()));
+			}
+		}
+		socket.close(ec);
+		finished.fetch_add(1);
+	}
+
+	uint32_t percentile(const std::vector<uint32_t>& sorted, double p) {
+		if (sorted.empty()) return 0;
+		size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+		return sorted[index];
+	}
+
+}
+
+int main(int argc, char* argv[]) {
+	size_t connections = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+	int seconds = argc > 2 ? std::atoi(argv[2]) : 10;
+	size_t payloadSize = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 64;
+	size_t serverThreads = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 2;
+	size_t clientThreads = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 2;
+	std::string mode = argc > 6 ? argv[6] : "safe";
+	if (connections == 0 || seconds <= 0 || payloadSize == 0 || serverThreads == 0 || clientThreads == 0 || (mode != "safe" && mode != "unsafe_io")) {
+		std::fprintf(stderr, "usage: %s [connections] [seconds] [payload bytes] [server threads] [client threads] [safe|unsafe_io]\n", argv[0]);
+		return 1;
+	}
+
+	// 服务端：一个 accept 线程，serverThreads 个 I/O 线程
+	boost::asio::io_context acceptContext(1);
+	int hint = mode == "unsafe_io" ? BOOST_ASIO_CONCURRENCY_HINT_UNSAFE_IO : 1;
+	std::vector<std::unique_ptr<boost::asio::io_context>> serverContexts;
+	std::vector<std::unique_ptr<ContextHandoff>> handoffs;
+	std::vector<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> works;
+	for (size_t i = 0; i < serverThreads; i++) {
+		serverContexts.push_back(std::make_unique<boost::asio::io_context>(hint));
+		handoffs.push_back(std::make_unique<ContextHandoff>(*serverContexts.back()));
+		works.push_back(boost::asio::make_work_guard(*serverContexts.back()));
+	}
+
+	tcp::acceptor acceptor(acceptContext, tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0));
+	tcp::endpoint endpoint = acceptor.local_endpoint();
+	boost::asio::co_spawn(acceptContext, accept(acceptor, serverContexts, handoffs), boost::asio::detached);
+
+	std::vector<std::thread> serverPool;
+	serverPool.emplace_back([&acceptContext]() { acceptContext.run(); });
+	for (auto& context : serverContexts) {
+		serverPool.emplace_back([&context]() { context->run(); });
+	}
+
+	// 客户端：连接轮流分配到 clientThreads 个 io_context，每个连接单独记录延迟，结束后合并
+	std::vector<std::unique_ptr<boost::asio::io_context>> clientContexts;
+	for (size_t i = 0; i < clientThreads; i++) {
+		clientContexts.push_back(std::make_unique<boost::asio::io_context>(1));
+	}
+
+	auto begin = std::chrono::steady_clock::now();
+	auto deadline = begin + std::chrono::seconds(seconds);
+	std::vector<std::vector<uint32_t>> latencies(connections);
+	std::atomic<size_t> finished{ 0 };
+
+	for (size_t i = 0; i < connections; i++) {
+		latencies[i].reserve(1 << 16);
+		boost::asio::co_spawn(*clientContexts[i % clientThreads], client(endpoint, payloadSize, deadline, latencies[i], finished), boost::asio::detached);
+	}
+
+	std::vector<std::thread> clientPool;
+	for (auto& context : clientContexts) {
+		clientPool.emplace_back([&context]() { context->run(); });
+	}
+	for (auto& thread : clientPool) {
+		thread.join();
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	boost::system::error_code ec;
+	acceptor.close(ec);
+	acceptContext.stop();
+	for (auto& context : serverContexts) {
+		context->stop();
+	}
+	for (auto& thread : serverPool) {
+		thread.join();
+	}
+
+	std::vector<uint32_t> merged;
+	for (const auto& samples : latencies) {
+		merged.insert(merged.end(), samples.begin(), samples.end());
+	}
+	std::sort(merged.begin(), merged.end());
+
+	std::printf("backend: %s, hint: %s, connections: %zu (finished %zu), payload: %zu bytes, server/client threads: %zu/%zu\n",
+		backendName(), mode.c_str(), connections, finished.load(), payloadSize, serverThreads, clientThreads);
+	std::printf("round trips: %zu, throughput: %0.0f msg/s\n", merged.size(), static_cast<double>(merged.size()) / elapsed);
+	std::printf("latency p50/p99/p999: %u/%u/%uus\n", percentile(merged, 0.5), percentile(merged, 0.99), percentile(merged, 0.999));
+
+	return merged.empty() ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+// 对比 LogicSystem 两种消息分发方式的开销：
+//   map   - std::map<short, std::function> 查找，处理器经 std::bind 绑定成员函数（原实现）
+//   table - LogicSystem 使用的 HandlerTable：按 uint16_t 消息 ID 直接索引的函数指针表（现实现，与服务器共用同一头文件）
+// 用法：DispatchBench [消息数] [处理器数]
+// 消息体预先构造，只测量查找与调用本身；处理器只累加长度，避免被编译器整体消除
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "HandlerTable.h"
+
+namespace {
+
+	struct Session {
+		uint64_t received = 0;
+	};
+
+	class Logic {
+	public:
+		void handleMessage(std::shared_ptr<Session> session, const short& msgId, const std::string& msgData) {
+			session->received += msgData.size();
+			checksum += static_cast<uint64_t>(msgId);
+		}
+
+		uint64_t checksum = 0;
+	};
+
+	class MapDispatcher {
+	public:
+		explicit MapDispatcher(Logic& logic) : logic(logic) {}
+
+		void registerCallBack(short msgId) {
+			callBackFunctions[msgId] = std::bind(&Logic::handleMessage, &logic,
+				std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+		}
+
+		void dispatch(const std::shared_ptr<Session>& session, short msgId, const std::string& msgData) {
+			auto iter = callBackFunctions.find(msgId);
+			if (iter != callBackFunctions.end()) {
+				iter->second(session, msgId, msgData);
+			}
+		}
+
+	private:
+		Logic& logic;
+
+		std::map<short, std::function<void(std::shared_ptr<Session>, const short&, const std::string&)>> callBackFunctions;
+	};
+
+	class TableDispatcher {
+	public:
+		explicit TableDispatcher(Logic& logic) : logic(logic) {}
+
+		template<void (Logic::* Method)(std::shared_ptr<Session>, const short&, const std::string&)>
+		void registerCallBack(short msgId) {
+			callBackFunctions.add<Method>(msgId);
+		}
+
+		// 与 LogicSystem::dispatchMessage 相同的查找与调用
+		void dispatch(const std::shared_ptr<Session>& session, short msgId, const std::string& msgData) {
+			auto callBack = callBackFunctions.find(msgId);
+			if (callBack != nullptr) {
+				callBack(logic, session, msgId, msgData);
+			}
+		}
+
+		size_t tableBytes() const { return callBackFunctions.bytes(); }
+
+	private:
+		Logic& logic;
+
+		HandlerTable<Logic, Session> callBackFunctions;
+	};
+
+	template<typename Dispatcher>
+	double run(Dispatcher& dispatcher, const std::vector<short>& ids, const std::shared_ptr<Session>& session, const std::string& payload) {
+		auto start = std::chrono::steady_clock::now();
+		for (short id : ids) {
+			dispatcher.dispatch(session, id, payload);
+		}
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(ids.size());
+	}
+
+}
+
+int main(int argc, char* argv[]) {
+	size_t messages = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000000;
+	int handlers = argc > 2 ? std::atoi(argv[2]) : 16;
+	if (messages == 0 || handlers <= 0) {
+		std::fprintf(stderr, "usage: %s [messages] [handlers]\n", argv[0]);
+		return 1;
+	}
+
+	// 与服务器一致，业务消息 ID 从 1001 开始
+	const short firstId = 1001;
+
+	Logic mapLogic;
+	Logic tableLogic;
+	MapDispatcher mapDispatcher(mapLogic);
+	TableDispatcher tableDispatcher(tableLogic);
+
+	for (int i = 0; i < handlers; i++) {
+		mapDispatcher.registerCallBack(static_cast<short>(firstId + i));
+		tableDispatcher.registerCallBack<&Logic::handleMessage>(static_cast<short>(firstId + i));
+	}
+
+	// 固定种子，两种方式使用相同的消息 ID 序列
+	std::mt19937 random(42);
+	std::uniform_int_distribution<int> pick(0, handlers - 1);
+	std::vector<short> ids(messages);
+	for (short& id : ids) {
+		id = static_cast<short>(firstId + pick(random));
+	}
+
+	auto session = std::make_shared<Session>();
+	const std::string payload(64, 'x');
+
+	// 先各跑一轮预热，再交替测量取最好成绩
+	run(mapDispatcher, ids, session, payload);
+	run(tableDispatcher, ids, session, payload);
+
+	double mapBest = 0;
+	double tableBest = 0;
+	for (int round = 0; round < 5; round++) {
+		double mapNanos = run(mapDispatcher, ids, session, payload);
+		double tableNanos = run(tableDispatcher, ids, session, payload);
+		mapBest = round == 0 ? mapNanos : std::min(mapBest, mapNanos);
+		tableBest = round == 0 ? tableNanos : std::min(tableBest, tableNanos);
+	}
+
+	std::printf("messages: %zu, handlers: %d, table: %zu bytes\n", messages, handlers, tableDispatcher.tableBytes());
+	std::printf("map   (std::map + std::function): %6.2f ns/msg\n", mapBest);
+	std::printf("table (function pointer table):  %6.2f ns/msg\n", tableBest);
+	std::printf("speedup: %0.2fx, checksum: %llu/%llu\n", mapBest / tableBest,
+		static_cast<unsigned long long>(mapLogic.checksum), static_cast<unsigned long long>(tableLogic.checksum));
+
+	return mapLogic.checksum == tableLogic.checksum ? 0 : 1;
+}
@@ -28,6 +28,16 @@
 #define HEAD_ID_LEN 2
 
 #define HEAD_DATA_LEN 8
+#define PROTOCOL_NEGOTIATE_ID 0x7FFF
+#define HEARTBEAT_ID 0x7FFE
+#define SERVER_BUSY_ID 0x7FFD
+#define RECV_BUFFER_SIZE 1024*64
+#define MAX_BODY_LENGTH 1024*1024*4
 #define MAX_RECVQUE  10000
+#define MAX_SESSION_RECVQUE 256
 #define MAX_SENDQUE 1000
+#define SEND_QUEUE_HIGH_BYTES 1024*1024*8
+#define MAX_WRITE_BATCH_BYTES 1024*256
+#define MAX_WRITE_BATCH_BUFFERS 64
+#define ZERO_COPY_THRESHOLD 1024
 
@@ -2,6 +2,7 @@
 #include"const.h"
 #include "CServer.h"
 #include "Utils.h"
+#include "LogicSystem.h"
 
 
 int main()
@@ -18,20 +19,8 @@ int main()
 
 		unsigned short port = static_cast<unsigned short> (ports);
 
-		boost::asio::io_context& ioContext = AsioProactors::getInstance()->getIoComplatePorts();
-
 		boost::asio::io_context ioContexts{ 1 };
 
-		boost::asio::signal_set signal(ioContexts, SIGINT, SIGTERM);
-
-		signal.async_wait([&ioContext, &ioContexts](auto,auto) {
-
-			ioContexts.stop();
-
-			ioContext.stop();
-
-			});
-
 		LOG_INFO(R"(
              _____  _____  ____    _____  ____   _____    ____   _    _  _______  _____  _   _  ______ 
      /\     / ____||_   _|/ __ \  / ____|/ __ \ |  __ \  / __ \ | |  | ||__   __||_   _|| \ | ||  ____|
@@ -46,7 +35,37 @@ int main()
 
 		CServer server(ioContexts, port);
 
+		std::string drainTimeout = config["SelfServer"]["DrainTimeoutMs"];
+
+		std::chrono::milliseconds timeout(drainTimeout.empty() ? 10000 : std::stoll(drainTimeout));
+
+		// 优雅关闭按顺序进行：排空会话 -> 停止 LogicSystem -> 停止 I/O 线程 -> 停止主 io_context
+		std::thread drainThread;
+
+		boost::asio::signal_set signal(ioContexts, SIGINT, SIGTERM);
+
+		signal.async_wait([&server, &ioContexts, &drainThread, timeout](auto,auto) {
+
+			drainThread = std::thread([&server, &ioContexts, timeout]() {
+
+				server.drain(timeout);
+
+				LogicSystem::getInstance()->stop();
+
+				AsioProactors::getInstance()->stop();
+
+				ioContexts.stop();
+
+				});
+			});
+
 		ioContexts.run();
+
+		if (drainThread.joinable()) {
+
+			drainThread.join();
+
+		}
 	}
 	catch (std::exception& e) {
 